@@ -0,0 +1,464 @@
+#include "GGMLDecoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+constexpr int kDefaultMaxContext = 2048;
+// GGML_ROPE_TYPE_NEOX rotates the two halves of a head; 0 rotates adjacent pairs (llama)
+constexpr int kRopeTypeNorm = 0;
+
+// Graph nodes per layer: shared projections, norms and FFN, plus the cache writes and attention of
+// each sequence
+constexpr size_t kNodesPerLayer = 32;
+constexpr size_t kNodesPerLayerSequence = 24;
+
+} // namespace
+
+GGMLDecoder::GGMLDecoder(const std::string& model_path, const GGMLDecoderOptions& options)
+{
+    try {
+        LOG(INFO) << "Loading GGML decoder: " << model_path;
+        backend_ = create_cpu_backend(options, &threadpool_);
+        model_ = std::make_unique<GGUFModel>(model_path, backend_);
+        load_hparams(options);
+        load_weights();
+        tokenizer_ = std::make_unique<GGMLTokenizer>(*model_);
+        if (static_cast<int>(tokenizer_->vocab_size()) != n_vocab_) {
+            throw ModelLoadException("Tokenizer has " + std::to_string(tokenizer_->vocab_size()) + " tokens, the model " + std::to_string(n_vocab_));
+        }
+        sequences_.resize(std::max(1, options.max_sequences));
+        allocate_cache();
+
+        n_batch_ = std::max(std::min(std::max(1, options.max_batch_tokens), n_ctx_), max_sequences());
+
+        // Measure the largest graphs once: every sequence stepping at the end of its context, and a
+        // full micro-batch of one sequence ending there. The allocator keeps the larger buffer.
+        allocr_ = ggml_gallocr_new(ggml_backend_get_default_buffer_type(backend_));
+        if (!allocr_) {
+            throw std::runtime_error("Failed to create the GGML graph allocator");
+        }
+        std::vector<BatchEntry> step_case;
+        for (int seq = 0; seq < max_sequences(); ++seq) {
+            step_case.push_back({seq, n_ctx_ - 1, 1});
+        }
+        const int prefill_tokens = std::min(n_batch_, n_ctx_);
+        reserve(step_case);
+        reserve({{0, n_ctx_ - prefill_tokens, prefill_tokens}});
+
+        LOG(INFO) << "GGML decoder loaded: " << arch_ << ", " << n_layer_ << " layers, " << n_vocab_ << " tokens, context "
+                  << n_ctx_ << " x " << max_sequences() << " sequences, " << n_batch_ << " tokens per pass, "
+                  << get_memory_usage_mb() << " MB";
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+GGMLDecoder::~GGMLDecoder()
+{
+    release();
+}
+
+void GGMLDecoder::release()
+{
+    if (allocr_) {
+        ggml_gallocr_free(allocr_);
+        allocr_ = nullptr;
+    }
+    if (cache_buffer_) {
+        ggml_backend_buffer_free(cache_buffer_);
+        cache_buffer_ = nullptr;
+    }
+    if (cache_ctx_) {
+        ggml_free(cache_ctx_);
+        cache_ctx_ = nullptr;
+    }
+    tokenizer_.reset();
+    model_.reset();
+    if (backend_) {
+        ggml_backend_free(backend_);
+        backend_ = nullptr;
+    }
+    if (threadpool_) {
+        ggml_threadpool_free(threadpool_);
+        threadpool_ = nullptr;
+    }
+}
+
+void GGMLDecoder::load_hparams(const GGMLDecoderOptions& options)
+{
+    arch_ = model_->architecture();
+    if (arch_ != "llama" && arch_ != "qwen2") {
+        throw ModelLoadException("Unsupported decoder architecture '" + arch_ + "', expected llama or qwen2");
+    }
+    const std::string prefix = arch_ + ".";
+    n_ctx_train_ = static_cast<int>(model_->get_int(prefix + "context_length"));
+    n_embd_ = static_cast<int>(model_->get_int(prefix + "embedding_length"));
+    n_layer_ = static_cast<int>(model_->get_int(prefix + "block_count"));
+    n_head_ = static_cast<int>(model_->get_int(prefix + "attention.head_count"));
+    n_head_kv_ = static_cast<int>(model_->get_int(prefix + "attention.head_count_kv", n_head_));
+    if (n_head_ <= 0 || n_head_kv_ <= 0 || n_embd_ % n_head_ != 0 || n_head_ % n_head_kv_ != 0) {
+        throw ModelLoadException("Invalid attention heads: " + std::to_string(n_head_) + " query, " + std::to_string(n_head_kv_) + " key/value");
+    }
+    head_dim_ = n_embd_ / n_head_;
+    n_rot_ = static_cast<int>(model_->get_int(prefix + "rope.dimension_count", head_dim_));
+    rope_type_ = arch_ == "qwen2" ? GGML_ROPE_TYPE_NEOX : kRopeTypeNorm;
+    rope_freq_base_ = model_->get_float(prefix + "rope.freq_base", 10000.0f);
+    norm_eps_ = model_->get_float(prefix + "attention.layer_norm_rms_epsilon", 1e-5f);
+
+    n_ctx_ = options.context_length > 0 ? options.context_length : std::min(n_ctx_train_, kDefaultMaxContext);
+}
+
+void GGMLDecoder::load_weights()
+{
+    token_embd_ = model_->get_tensor("token_embd.weight");
+    n_vocab_ = static_cast<int>(token_embd_->ne[1]);
+    output_norm_ = model_->get_tensor("output_norm.weight");
+    // Tied embeddings reuse the token embedding as the output projection
+    output_ = model_->get_tensor("output.weight", false);
+    if (!output_) {
+        output_ = token_embd_;
+    }
+
+    layers_.resize(n_layer_);
+    for (int i = 0; i < n_layer_; ++i) {
+        const std::string block = "blk." + std::to_string(i) + ".";
+        Layer& layer = layers_[i];
+        layer.attn_norm = model_->get_tensor(block + "attn_norm.weight");
+        layer.wq = model_->get_tensor(block + "attn_q.weight");
+        layer.wk = model_->get_tensor(block + "attn_k.weight");
+        layer.wv = model_->get_tensor(block + "attn_v.weight");
+        layer.wo = model_->get_tensor(block + "attn_output.weight");
+        layer.bq = model_->get_tensor(block + "attn_q.bias", false);
+        layer.bk = model_->get_tensor(block + "attn_k.bias", false);
+        layer.bv = model_->get_tensor(block + "attn_v.bias", false);
+        layer.ffn_norm = model_->get_tensor(block + "ffn_norm.weight");
+        layer.ffn_gate = model_->get_tensor(block + "ffn_gate.weight");
+        layer.ffn_up = model_->get_tensor(block + "ffn_up.weight");
+        layer.ffn_down = model_->get_tensor(block + "ffn_down.weight");
+    }
+}
+
+void GGMLDecoder::allocate_cache()
+{
+    ggml_init_params params = {
+        .mem_size = ggml_tensor_overhead() * 2 * layers_.size(),
+        .mem_buffer = nullptr,
+        .no_alloc = true
+    };
+    cache_ctx_ = ggml_init(params);
+    if (!cache_ctx_) {
+        throw std::runtime_error("Failed to initialize the KV cache context");
+    }
+    for (auto& layer : layers_) {
+        layer.k_cache = ggml_new_tensor_4d(cache_ctx_, GGML_TYPE_F16, head_dim_, n_head_kv_, n_ctx_, max_sequences());
+        layer.v_cache = ggml_new_tensor_4d(cache_ctx_, GGML_TYPE_F16, head_dim_, n_head_kv_, n_ctx_, max_sequences());
+    }
+    cache_buffer_ = ggml_backend_alloc_ctx_tensors(cache_ctx_, backend_);
+    if (!cache_buffer_) {
+        throw ModelLoadException("Failed to allocate the KV cache");
+    }
+    ggml_backend_buffer_clear(cache_buffer_, 0);
+}
+
+size_t GGMLDecoder::graph_size(size_t num_sequences) const
+{
+    return std::max<size_t>(GGML_DEFAULT_GRAPH_SIZE, layers_.size() * (kNodesPerLayer + kNodesPerLayerSequence * num_sequences) + 64);
+}
+
+GGMLDecoder::Graph GGMLDecoder::build_graph(struct ggml_context* ctx, const std::vector<BatchEntry>& batch)
+{
+    const int64_t n_tokens = std::accumulate(batch.begin(), batch.end(), int64_t{0},
+        [](int64_t sum, const BatchEntry& entry) { return sum + entry.n_tokens; });
+    const float kq_scale = 1.0f / std::sqrt(static_cast<float>(head_dim_));
+
+    Graph g;
+    g.graph = ggml_new_graph_custom(ctx, graph_size(batch.size()), false);
+    g.tokens = ggml_new_tensor_1d(ctx, GGML_TYPE_I32, n_tokens);
+    g.positions = ggml_new_tensor_1d(ctx, GGML_TYPE_I32, n_tokens);
+    g.last = ggml_new_tensor_1d(ctx, GGML_TYPE_I32, static_cast<int64_t>(batch.size()));
+    ggml_set_input(g.tokens);
+    ggml_set_input(g.positions);
+    ggml_set_input(g.last);
+
+    const auto linear = [ctx](struct ggml_tensor* x, struct ggml_tensor* weight, struct ggml_tensor* bias) {
+        x = ggml_mul_mat(ctx, weight, x);
+        return bias ? ggml_add(ctx, x, bias) : x;
+    };
+    const auto rope = [&](struct ggml_tensor* x) {
+        return ggml_rope_ext(ctx, x, g.positions, nullptr, n_rot_, rope_type_, n_ctx_train_, rope_freq_base_,
+            1.0f, 0.0f, 1.0f, 32.0f, 1.0f);
+    };
+
+    // Tokens of all sequences, one after the other: [n_embd, n_tokens]
+    struct ggml_tensor* x = ggml_get_rows(ctx, token_embd_, g.tokens);
+    for (const auto& layer : layers_) {
+        struct ggml_tensor* cur = ggml_mul(ctx, ggml_rms_norm(ctx, x, norm_eps_), layer.attn_norm);
+        struct ggml_tensor* q = rope(ggml_reshape_3d(ctx, linear(cur, layer.wq, layer.bq), head_dim_, n_head_, n_tokens));
+        struct ggml_tensor* k = rope(ggml_reshape_3d(ctx, linear(cur, layer.wk, layer.bk), head_dim_, n_head_kv_, n_tokens));
+        struct ggml_tensor* v = ggml_reshape_3d(ctx, linear(cur, layer.wv, layer.bv), head_dim_, n_head_kv_, n_tokens);
+
+        struct ggml_tensor* attention = nullptr;
+        int64_t offset = 0;
+        for (const auto& entry : batch) {
+            const int64_t n = entry.n_tokens;
+            const int64_t n_kv = entry.n_past + n;
+            const size_t region = entry.seq * layer.k_cache->nb[3];
+
+            // Store the new keys and values at the sequence's next cache positions. The copies are
+            // added to the graph before the attention below, which reads them back from the cache.
+            for (auto [src, cache] : {std::make_pair(k, layer.k_cache), std::make_pair(v, layer.v_cache)}) {
+                struct ggml_tensor* rows = ggml_view_3d(ctx, src, head_dim_, n_head_kv_, n, src->nb[1], src->nb[2], offset * src->nb[2]);
+                struct ggml_tensor* slots = ggml_view_3d(ctx, cache, head_dim_, n_head_kv_, n, cache->nb[1], cache->nb[2],
+                    region + entry.n_past * cache->nb[2]);
+                ggml_build_forward_expand(g.graph, ggml_cpy(ctx, rows, slots));
+            }
+
+            // [head_dim, n, n_head] queries against [head_dim, n_kv, n_head_kv] keys; grouped query
+            // heads share a key/value head through the matmul broadcast
+            struct ggml_tensor* queries = ggml_permute(ctx,
+                ggml_view_3d(ctx, q, head_dim_, n_head_, n, q->nb[1], q->nb[2], offset * q->nb[2]), 0, 2, 1, 3);
+            struct ggml_tensor* keys = ggml_permute(ctx,
+                ggml_view_3d(ctx, layer.k_cache, head_dim_, n_head_kv_, n_kv, layer.k_cache->nb[1], layer.k_cache->nb[2], region), 0, 2, 1, 3);
+            struct ggml_tensor* kq = ggml_scale(ctx, ggml_mul_mat(ctx, keys, queries), kq_scale);  // [n_kv, n, n_head]
+            if (n > 1) {
+                kq = ggml_diag_mask_inf(ctx, kq, entry.n_past);
+            }
+            kq = ggml_soft_max(ctx, kq);
+
+            // Values transposed to [n_kv, head_dim, n_head_kv] for the weighted sum
+            struct ggml_tensor* values = ggml_cont(ctx, ggml_permute(ctx,
+                ggml_view_3d(ctx, layer.v_cache, head_dim_, n_head_kv_, n_kv, layer.v_cache->nb[1], layer.v_cache->nb[2], region), 1, 2, 0, 3));
+            struct ggml_tensor* out = ggml_mul_mat(ctx, values, kq);  // [head_dim, n, n_head]
+            out = ggml_reshape_2d(ctx, ggml_cont(ctx, ggml_permute(ctx, out, 0, 2, 1, 3)), n_embd_, n);
+            attention = attention ? ggml_concat(ctx, attention, out, 1) : out;
+            offset += n;
+        }
+        x = ggml_add(ctx, x, ggml_mul_mat(ctx, layer.wo, attention));
+
+        cur = ggml_mul(ctx, ggml_rms_norm(ctx, x, norm_eps_), layer.ffn_norm);
+        cur = ggml_mul(ctx, ggml_silu(ctx, ggml_mul_mat(ctx, layer.ffn_gate, cur)), ggml_mul_mat(ctx, layer.ffn_up, cur));
+        x = ggml_add(ctx, x, ggml_mul_mat(ctx, layer.ffn_down, cur));
+    }
+
+    // Only each sequence's last token needs logits
+    x = ggml_get_rows(ctx, x, g.last);
+    x = ggml_mul(ctx, ggml_rms_norm(ctx, x, norm_eps_), output_norm_);
+    g.logits = ggml_mul_mat(ctx, output_, x);
+    ggml_set_output(g.logits);
+    ggml_build_forward_expand(g.graph, g.logits);
+    return g;
+}
+
+struct ggml_context* GGMLDecoder::graph_context(size_t num_sequences)
+{
+    const size_t size = graph_size(num_sequences);
+    graph_meta_.resize(std::max(graph_meta_.size(), ggml_tensor_overhead() * size + ggml_graph_overhead_custom(size, false)));
+    ggml_init_params params = {
+        .mem_size = graph_meta_.size(),
+        .mem_buffer = graph_meta_.data(),
+        .no_alloc = true
+    };
+    return ggml_init(params);
+}
+
+void GGMLDecoder::reserve(const std::vector<BatchEntry>& batch)
+{
+    struct ggml_context* ctx = graph_context(batch.size());
+    const bool reserved = ggml_gallocr_reserve(allocr_, build_graph(ctx, batch).graph);
+    ggml_free(ctx);
+    if (!reserved) {
+        throw ModelLoadException("Failed to reserve the decoder compute buffer");
+    }
+}
+
+std::vector<std::vector<float>> GGMLDecoder::run_batch(const std::vector<BatchEntry>& batch, const std::vector<int32_t>& token_ids,
+    const std::vector<int32_t>& positions, const std::vector<int32_t>& last)
+{
+    std::unique_ptr<struct ggml_context, decltype(&ggml_free)> ctx(graph_context(batch.size()), &ggml_free);
+    if (!ctx) {
+        throw InferenceExecutionException("Failed to initialize the graph context");
+    }
+
+    const Graph g = build_graph(ctx.get(), batch);
+    if (!ggml_gallocr_alloc_graph(allocr_, g.graph)) {
+        throw InferenceExecutionException("Failed to allocate the decoder graph");
+    }
+    ggml_backend_tensor_set(g.tokens, token_ids.data(), 0, ggml_nbytes(g.tokens));
+    ggml_backend_tensor_set(g.positions, positions.data(), 0, ggml_nbytes(g.positions));
+    ggml_backend_tensor_set(g.last, last.data(), 0, ggml_nbytes(g.last));
+
+    if (ggml_backend_graph_compute(backend_, g.graph) != GGML_STATUS_SUCCESS) {
+        throw InferenceExecutionException("GGML decoder graph computation failed");
+    }
+    for (const auto& entry : batch) {
+        sequences_[entry.seq].length += entry.n_tokens;
+    }
+
+    std::vector<std::vector<float>> logits(batch.size(), std::vector<float>(n_vocab_));
+    for (size_t i = 0; i < batch.size(); ++i) {
+        ggml_backend_tensor_get(g.logits, logits[i].data(), i * g.logits->nb[1], n_vocab_ * sizeof(float));
+    }
+    return logits;
+}
+
+std::vector<std::vector<float>> GGMLDecoder::evaluate(const std::vector<int>& seqs, const std::vector<std::vector<int32_t>>& tokens)
+{
+    if (seqs.empty() || seqs.size() != tokens.size()) {
+        throw InferenceExecutionException("Expected one token list per sequence");
+    }
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        const int seq = seqs[i];
+        if (seq < 0 || seq >= max_sequences() || !sequences_[seq].active) {
+            throw InferenceExecutionException("Unknown sequence " + std::to_string(seq));
+        }
+        if (std::count(seqs.begin(), seqs.end(), seq) > 1) {
+            throw InferenceExecutionException("Sequence " + std::to_string(seq) + " appears twice in one batch");
+        }
+        const int n = static_cast<int>(tokens[i].size());
+        if (n == 0) {
+            throw InferenceExecutionException("No tokens for sequence " + std::to_string(seq));
+        }
+        if (sequences_[seq].length + n > n_ctx_) {
+            throw InferenceExecutionException("Sequence " + std::to_string(seq) + " exceeds the context length " + std::to_string(n_ctx_));
+        }
+        for (int32_t token : tokens[i]) {
+            if (token < 0 || token >= n_vocab_) {
+                throw InferenceExecutionException("Token id out of range: " + std::to_string(token));
+            }
+        }
+    }
+
+    // Micro-batches of up to n_batch_ tokens: each pass takes the next tokens of the sequences in
+    // order until the budget is spent, so a step of every sequence is still one pass
+    std::vector<std::vector<float>> logits(seqs.size());
+    std::vector<size_t> done(seqs.size(), 0);
+    for (bool pending = true; pending;) {
+        std::vector<size_t> members;
+        std::vector<BatchEntry> batch;
+        std::vector<int32_t> token_ids;
+        std::vector<int32_t> positions;
+        std::vector<int32_t> last;
+        int budget = n_batch_;
+        for (size_t i = 0; i < seqs.size() && budget > 0; ++i) {
+            const int n = static_cast<int>(std::min<size_t>(tokens[i].size() - done[i], budget));
+            if (n == 0) {
+                continue;
+            }
+            const int n_past = sequences_[seqs[i]].length;
+            for (int t = 0; t < n; ++t) {
+                token_ids.push_back(tokens[i][done[i] + t]);
+                positions.push_back(n_past + t);
+            }
+            last.push_back(static_cast<int32_t>(token_ids.size()) - 1);
+            batch.push_back({seqs[i], n_past, n});
+            members.push_back(i);
+            budget -= n;
+        }
+
+        auto pass = run_batch(batch, token_ids, positions, last);
+        pending = false;
+        for (size_t k = 0; k < members.size(); ++k) {
+            const size_t i = members[k];
+            done[i] += batch[k].n_tokens;
+            if (done[i] == tokens[i].size()) {
+                logits[i] = std::move(pass[k]);
+            }
+        }
+        for (size_t i = 0; i < seqs.size(); ++i) {
+            pending = pending || done[i] < tokens[i].size();
+        }
+    }
+    return logits;
+}
+
+int GGMLDecoder::new_sequence()
+{
+    for (int seq = 0; seq < max_sequences(); ++seq) {
+        if (!sequences_[seq].active) {
+            sequences_[seq] = {true, 0};
+            return seq;
+        }
+    }
+    return -1;
+}
+
+void GGMLDecoder::free_sequence(int seq)
+{
+    if (seq >= 0 && seq < max_sequences()) {
+        // Stale cache entries are never read: attention only spans the positions written since
+        sequences_[seq] = Sequence();
+    }
+}
+
+int GGMLDecoder::sequence_length(int seq) const
+{
+    if (seq < 0 || seq >= max_sequences() || !sequences_[seq].active) {
+        throw InferenceExecutionException("Unknown sequence " + std::to_string(seq));
+    }
+    return sequences_[seq].length;
+}
+
+std::vector<std::vector<float>> GGMLDecoder::prefill(const std::vector<int>& seqs, const std::vector<std::vector<int32_t>>& tokens)
+{
+    return evaluate(seqs, tokens);
+}
+
+std::vector<float> GGMLDecoder::prefill(int seq, const std::vector<int32_t>& tokens)
+{
+    return evaluate({seq}, {tokens}).front();
+}
+
+std::vector<std::vector<float>> GGMLDecoder::step(const std::vector<int>& seqs, const std::vector<int32_t>& tokens)
+{
+    if (seqs.size() != tokens.size()) {
+        throw InferenceExecutionException("Expected one token per sequence");
+    }
+    std::vector<std::vector<int32_t>> batch;
+    for (int32_t token : tokens) {
+        batch.push_back({token});
+    }
+    return evaluate(seqs, batch);
+}
+
+std::string GGMLDecoder::generate(const std::string& prompt, int max_new_tokens)
+{
+    const int seq = new_sequence();
+    if (seq < 0) {
+        throw InferenceExecutionException("No free sequence for generation");
+    }
+    struct Release {
+        GGMLDecoder* decoder;
+        int seq;
+        ~Release() { decoder->free_sequence(seq); }
+    } release{this, seq};
+
+    std::vector<int32_t> generated;
+    std::vector<float> logits = prefill(seq, tokenizer_->encode(prompt));
+    for (int i = 0; i < max_new_tokens; ++i) {
+        const int32_t token = static_cast<int32_t>(std::max_element(logits.begin(), logits.end()) - logits.begin());
+        if (tokenizer_->is_end_of_generation(token)) {
+            break;
+        }
+        generated.push_back(token);
+        if (i + 1 == max_new_tokens || sequence_length(seq) == n_ctx_) {
+            break;
+        }
+        logits = step({seq}, {token}).front();
+    }
+    return tokenizer_->decode(generated);
+}
+
+size_t GGMLDecoder::get_memory_usage_mb() const noexcept
+{
+    size_t bytes = model_ ? model_->size_bytes() : 0;
+    if (cache_buffer_) {
+        bytes += ggml_backend_buffer_get_size(cache_buffer_);
+    }
+    if (allocr_) {
+        bytes += ggml_gallocr_get_buffer_size(allocr_, 0);
+    }
+    return bytes / (1024 * 1024);
+}
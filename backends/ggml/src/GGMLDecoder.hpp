@@ -0,0 +1,144 @@
+#pragma once
+#include "GGMLTokenizer.hpp"
+#include <ggml-alloc.h>
+#include <memory>
+
+struct GGMLDecoderOptions : GGMLOptions {
+    // Cache positions per sequence, 0 uses the model's context length capped at 2048
+    int context_length = 0;
+    // Sequences that can be decoded together, each owning a region of the shared KV cache
+    int max_sequences = 1;
+    // Tokens per forward pass: longer prefills run in micro-batches of this size, which bounds the
+    // attention scores and so the compute buffer (raised to max_sequences so a step fits one pass)
+    int max_batch_tokens = 64;
+};
+
+// Autoregressive decoding of decoder-only GGUF transformers ("llama" and "qwen2" architectures as
+// written by llama.cpp's convert_hf_to_gguf.py), next to the single-shot GGMLInfer. Keys and
+// values of every processed token stay in an F16 cache allocated once in a backend buffer, so each
+// step only runs the new tokens. Sequences are independent: a forward pass batches the projections
+// and FFN of all of them and attends per sequence over its own cache region.
+// Not thread-safe, like the other engines.
+class GGMLDecoder
+{
+public:
+    explicit GGMLDecoder(const std::string& model_path, const GGMLDecoderOptions& options = GGMLDecoderOptions());
+    ~GGMLDecoder();
+
+    GGMLDecoder(const GGMLDecoder&) = delete;
+    GGMLDecoder& operator=(const GGMLDecoder&) = delete;
+
+    const GGMLTokenizer& tokenizer() const { return *tokenizer_; }
+    int context_length() const { return n_ctx_; }
+    int max_sequences() const { return static_cast<int>(sequences_.size()); }
+    int max_batch_tokens() const { return n_batch_; }
+    int vocab_size() const { return n_vocab_; }
+
+    // Claims an empty cache region and returns its sequence id, -1 when all are in use
+    int new_sequence();
+    // Releases the sequence's cache region for a new sequence
+    void free_sequence(int seq);
+    // Tokens already in the sequence's cache
+    int sequence_length(int seq) const;
+
+    // Appends the tokens to each sequence's cache, in forward passes of up to max_batch_tokens, and
+    // returns the logits after each sequence's last token. Lengths may differ between sequences.
+    std::vector<std::vector<float>> prefill(const std::vector<int>& seqs, const std::vector<std::vector<int32_t>>& tokens);
+    std::vector<float> prefill(int seq, const std::vector<int32_t>& tokens);
+    // Appends one token to each sequence, batched in one forward pass; returns logits per sequence
+    std::vector<std::vector<float>> step(const std::vector<int>& seqs, const std::vector<int32_t>& tokens);
+
+    // Greedy decoding of a prompt until end of generation or max_new_tokens, on a temporary sequence
+    std::string generate(const std::string& prompt, int max_new_tokens);
+
+    // Weights, KV cache and compute buffer
+    size_t get_memory_usage_mb() const noexcept;
+
+private:
+    struct Layer {
+        struct ggml_tensor* attn_norm;
+        struct ggml_tensor* wq;
+        struct ggml_tensor* wk;
+        struct ggml_tensor* wv;
+        struct ggml_tensor* wo;
+        struct ggml_tensor* bq;  // Biases are optional (qwen2 has them)
+        struct ggml_tensor* bk;
+        struct ggml_tensor* bv;
+        struct ggml_tensor* ffn_norm;
+        struct ggml_tensor* ffn_gate;
+        struct ggml_tensor* ffn_up;
+        struct ggml_tensor* ffn_down;
+        struct ggml_tensor* k_cache;  // [head_dim, n_head_kv, n_ctx, max_sequences]
+        struct ggml_tensor* v_cache;
+    };
+
+    // New tokens of one sequence in a forward pass
+    struct BatchEntry {
+        int seq;
+        int n_past;
+        int n_tokens;
+    };
+
+    struct Graph {
+        struct ggml_cgraph* graph;
+        struct ggml_tensor* tokens;
+        struct ggml_tensor* positions;
+        struct ggml_tensor* last;    // Row of each sequence's last token
+        struct ggml_tensor* logits;  // [n_vocab, sequences]
+    };
+
+    void load_hparams(const GGMLDecoderOptions& options);
+    void load_weights();
+    void allocate_cache();
+    size_t graph_size(size_t num_sequences) const;
+    Graph build_graph(struct ggml_context* ctx, const std::vector<BatchEntry>& batch);
+    struct ggml_context* graph_context(size_t num_sequences);
+    void reserve(const std::vector<BatchEntry>& batch);
+    std::vector<std::vector<float>> run_batch(const std::vector<BatchEntry>& batch, const std::vector<int32_t>& token_ids,
+        const std::vector<int32_t>& positions, const std::vector<int32_t>& last);
+    std::vector<std::vector<float>> evaluate(const std::vector<int>& seqs, const std::vector<std::vector<int32_t>>& tokens);
+    void release();
+
+    struct Sequence {
+        bool active = false;
+        int length = 0;
+    };
+
+    ggml_backend_t backend_ = nullptr;
+    struct ggml_threadpool* threadpool_ = nullptr;
+    std::unique_ptr<GGUFModel> model_;
+    std::unique_ptr<GGMLTokenizer> tokenizer_;
+
+    std::string arch_;
+    int n_vocab_ = 0;
+    int n_ctx_ = 0;
+    int n_ctx_train_ = 0;
+    int n_batch_ = 0;
+    int n_embd_ = 0;
+    int n_layer_ = 0;
+    int n_head_ = 0;
+    int n_head_kv_ = 0;
+    int head_dim_ = 0;
+    int n_rot_ = 0;
+    int rope_type_ = 0;
+    float rope_freq_base_ = 10000.0f;
+    float norm_eps_ = 1e-5f;
+
+    struct ggml_tensor* token_embd_ = nullptr;
+    struct ggml_tensor* output_norm_ = nullptr;
+    struct ggml_tensor* output_ = nullptr;
+    std::vector<Layer> layers_;
+
+    // KV cache: its tensors' metadata and the backend buffer holding them
+    struct ggml_context* cache_ctx_ = nullptr;
+    ggml_backend_buffer_t cache_buffer_ = nullptr;
+    std::vector<Sequence> sequences_;
+
+    // Graphs are rebuilt per forward pass in this reused metadata buffer; the allocator keeps its
+    // compute buffer across passes, reserved up front for the larger of a full-context step of every
+    // sequence and a full micro-batch of one sequence at the end of its context. A micro-batch that
+    // splits its tokens over several long sequences may need a little more, and the allocator then
+    // grows the buffer once.
+    std::vector<uint8_t> graph_meta_;
+    ggml_gallocr_t allocr_ = nullptr;
+};
@@ -1,212 +1,383 @@
 #include "GGMLInfer.hpp"
-#include <fstream>
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
-#include <ggml-cpu.h>
 
-GGMLInfer::GGMLInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes) 
+namespace {
+
+// Upper bound of ggml tensors created per graph node (conv2d expands to im2col, reshapes,
+// matmul, permute, cont and the bias add)
+constexpr size_t kTensorsPerNode = 16;
+
+} // namespace
+
+GGMLInfer::GGMLInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes,
+    const GGMLOptions& options)
     : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
     , ctx_(nullptr)
     , backend_(nullptr)
     , graph_(nullptr)
     , input_tensor_(nullptr)
     , model_loaded_(false)
+    , allocr_(nullptr)
+    , threadpool_(nullptr)
+    , graph_batch_(0)
 {
     try {
         LOG(INFO) << "Running using GGML runtime: " << model_path;
-        
-        // Initialize GGML
-        ggml_init_params params = {
-            .mem_size = 1024 * 1024 * 1024, // 1GB
-            .mem_buffer = nullptr,
-            .no_alloc = true
-        };
-        
-        ctx_ = ggml_init(params);
-        if (!ctx_) {
-            throw std::runtime_error("Failed to initialize GGML context");
-        }
-        
+
         // Setup backend (CPU or GPU)
-        setup_backend(use_gpu);
-        
+        setup_backend(use_gpu, options);
+
         // Load model
         load_model(model_path);
-        
+
         // Setup input/output tensors
         setup_input_output_tensors(input_sizes);
-        
+
         model_loaded_ = true;
-        
+
     } catch (const std::exception& e) {
-        if (ctx_) {
-            ggml_free(ctx_);
-            ctx_ = nullptr;
-        }
+        release();
         throw;
     }
 }
 
 GGMLInfer::~GGMLInfer()
 {
+    release();
+}
+
+void GGMLInfer::release()
+{
+    if (allocr_) {
+        ggml_gallocr_free(allocr_);
+        allocr_ = nullptr;
+    }
+    // Weights live in a buffer of the backend, freed first
+    model_.reset();
     if (backend_) {
         ggml_backend_free(backend_);
+        backend_ = nullptr;
+    }
+    if (threadpool_) {
+        ggml_threadpool_free(threadpool_);
+        threadpool_ = nullptr;
     }
     if (ctx_) {
         ggml_free(ctx_);
+        ctx_ = nullptr;
     }
 }
 
-void GGMLInfer::setup_backend(bool use_gpu)
+void GGMLInfer::setup_backend(bool use_gpu, const GGMLOptions& options)
 {
     if (use_gpu) {
         // Try to use GPU backend if available
         // For now, fall back to CPU since CUDA backend setup is complex
         LOG(WARNING) << "GPU backend not implemented yet, using CPU";
-        backend_ = ggml_backend_cpu_init();
     } else {
-        backend_ = ggml_backend_cpu_init();
         LOG(INFO) << "Using CPU backend";
     }
-    
-    if (!backend_) {
-        throw std::runtime_error("Failed to initialize GGML backend");
+    backend_ = create_cpu_backend(options, &threadpool_);
+
+    allocr_ = ggml_gallocr_new(ggml_backend_get_default_buffer_type(backend_));
+    if (!allocr_) {
+        throw std::runtime_error("Failed to create the GGML graph allocator");
     }
 }
 
 void GGMLInfer::load_model(const std::string& model_path)
 {
-    // Check if file exists
-    std::ifstream file(model_path, std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open model file: " + model_path);
-    }
-    
-    // For now, we'll create a simple placeholder model
-    // In a real implementation, you would load the actual GGML model format
     LOG(INFO) << "Loading GGML model from: " << model_path;
-    
-    // Create a simple graph for demonstration
-    // In practice, you would parse the actual model file
-    // OpenCV blobFromImage creates (batch, channels, height, width) format
-    input_tensor_ = ggml_new_tensor_4d(ctx_, GGML_TYPE_F32, 3, 224, 224, batch_size_);
-    
-    // Create a simple output tensor (this would be replaced with actual model loading)
-    struct ggml_tensor* output_tensor = ggml_new_tensor_2d(ctx_, GGML_TYPE_F32, 1000, batch_size_);
-    
-    // Create computation graph
-    graph_ = ggml_new_graph(ctx_);
-    ggml_build_forward_expand(graph_, output_tensor);
-    
-    // Allocate backend buffer
-    ggml_backend_buffer_t buffer = ggml_backend_alloc_ctx_tensors(ctx_, backend_);
-    if (!buffer) {
-        LOG(WARNING) << "Failed to allocate backend buffer, continuing without backend allocation";
-        // For now, we'll continue without backend allocation for testing
-        // In a real implementation, this would be required
-    }
-    
-    LOG(INFO) << "GGML model loaded successfully";
+
+    model_ = std::make_unique<GGUFModel>(model_path, backend_);
+    const std::string architecture = model_->architecture();
+    if (architecture != "cnn") {
+        throw ModelLoadException("Unsupported GGUF architecture '" + architecture + "' in " + model_path);
+    }
+
+    parse_graph();
+    LOG(INFO) << "GGML model loaded successfully: " << model_->num_tensors() << " tensors, "
+              << nodes_.size() << " nodes, " << model_->size_bytes() / (1024 * 1024) << " MB weights"
+              << (model_->num_quantized_tensors() > 0 ? ", " + std::to_string(model_->num_quantized_tensors()) + " quantized" : std::string());
+}
+
+void GGMLInfer::parse_graph()
+{
+    input_shape_ = model_->get_int_array("cnn.input_shape");
+    if (input_shape_.size() != 3) {
+        throw ModelLoadException("cnn.input_shape must be [C, H, W]");
+    }
+
+    for (const auto& line : model_->get_string_array("cnn.graph")) {
+        std::istringstream stream(line);
+        GGMLNode node;
+        std::string inputs;
+        if (!(stream >> node.op >> node.output >> inputs)) {
+            throw ModelLoadException("Malformed graph node: " + line);
+        }
+        std::istringstream input_stream(inputs);
+        for (std::string input; std::getline(input_stream, input, ',');) {
+            node.inputs.push_back(input);
+        }
+        for (std::string param; stream >> param;) {
+            const auto eq = param.find('=');
+            if (eq == std::string::npos) {
+                throw ModelLoadException("Malformed node parameter '" + param + "' in: " + line);
+            }
+            const std::string key = param.substr(0, eq);
+            const std::string value = param.substr(eq + 1);
+            try {
+                size_t parsed = 0;
+                node.params[key] = std::stoi(value, &parsed);
+                if (parsed != value.size()) {
+                    throw std::invalid_argument("trailing characters");
+                }
+            } catch (const std::exception&) {
+                throw ModelLoadException("Invalid value '" + value + "' for parameter '" + key + "' of " + node.op +
+                    " node '" + node.output + "'");
+            }
+        }
+        nodes_.push_back(std::move(node));
+    }
+    output_names_ = model_->get_string_array("cnn.outputs");
+}
+
+struct ggml_tensor* GGMLInfer::build_node(struct ggml_context* ctx, const GGMLNode& node,
+    const std::vector<struct ggml_tensor*>& inputs, int& rank)
+{
+    const auto param = [&node](const char* key, int fallback) {
+        const auto it = node.params.find(key);
+        return it == node.params.end() ? fallback : it->second;
+    };
+    // Per-channel vector [C] broadcast over a [W, H, C, N] feature map
+    const auto channel_view = [ctx](struct ggml_tensor* vector) {
+        return ggml_reshape_4d(ctx, vector, 1, 1, vector->ne[0], 1);
+    };
+
+    struct ggml_tensor* x = inputs[0];
+    if (node.op == "conv2d") {
+        // Kernel [KW, KH, IC, OC], feature maps [W, H, C, N]
+        const int stride = param("stride", 1);
+        const int pad = param("pad", 0);
+        const int dilation = param("dilation", 1);
+        struct ggml_tensor* weight = model_->get_tensor(node.output + ".weight");
+        if (ggml_is_quantized(weight->type)) {
+            // Quantized kernel stored as a [KW*KH*IC, OC] matrix: ggml_conv_2d would im2col in the
+            // kernel type, so unfold the input in F32 and let the quantized matmul kernel do the rest.
+            // Keyed on the type, not the rank: an F32 kernel with IC == OC == 1 is [KW, KH] too
+            const int kernel_w = param("kw", 1);
+            const int kernel_h = param("kh", 1);
+            // im2col only reads the kernel geometry from its first operand
+            struct ggml_tensor* geometry = ggml_new_tensor_4d(ctx, GGML_TYPE_F32, kernel_w, kernel_h, weight->ne[0] / (kernel_w * kernel_h), 1);
+            struct ggml_tensor* cols = ggml_im2col(ctx, geometry, x, stride, stride, pad, pad, dilation, dilation, true, GGML_TYPE_F32);
+            x = ggml_mul_mat(ctx, weight, ggml_reshape_2d(ctx, cols, cols->ne[0], cols->ne[1] * cols->ne[2] * cols->ne[3]));
+            // [OC, OW, OH, N] -> [OW, OH, OC, N]
+            x = ggml_reshape_4d(ctx, x, weight->ne[1], cols->ne[1], cols->ne[2], cols->ne[3]);
+            x = ggml_cont(ctx, ggml_permute(ctx, x, 2, 0, 1, 3));
+        } else {
+            x = ggml_conv_2d(ctx, weight, x, stride, stride, pad, pad, dilation, dilation);
+        }
+        if (struct ggml_tensor* bias = model_->get_tensor(node.output + ".bias", false)) {
+            x = ggml_add(ctx, x, channel_view(bias));
+        }
+    } else if (node.op == "affine") {
+        // Standalone batchnorm: per-channel scale and shift
+        x = ggml_add(ctx, ggml_mul(ctx, x, channel_view(model_->get_tensor(node.output + ".weight"))),
+            channel_view(model_->get_tensor(node.output + ".bias")));
+    } else if (node.op == "relu") {
+        x = ggml_relu(ctx, x);
+    } else if (node.op == "maxpool2d" || node.op == "avgpool2d") {
+        const int kernel = param("kernel", 2);
+        const int stride = param("stride", kernel);
+        const float pad = static_cast<float>(param("pad", 0));
+        x = ggml_pool_2d(ctx, x, node.op == "maxpool2d" ? GGML_OP_POOL_MAX : GGML_OP_POOL_AVG,
+            kernel, kernel, stride, stride, pad, pad);
+    } else if (node.op == "global_avgpool") {
+        x = ggml_pool_2d(ctx, x, GGML_OP_POOL_AVG, x->ne[0], x->ne[1], x->ne[0], x->ne[1], 0, 0);
+    } else if (node.op == "add") {
+        if (inputs.size() != 2) {
+            throw ModelLoadException("add expects two inputs: " + node.output);
+        }
+        x = ggml_add(ctx, inputs[0], inputs[1]);
+    } else if (node.op == "flatten") {
+        // [W, H, C, N] with W fastest is the row-major C*H*W order of the source framework
+        if (!ggml_is_contiguous(x)) {
+            x = ggml_cont(ctx, x);
+        }
+        x = ggml_reshape_2d(ctx, x, x->ne[0] * x->ne[1] * x->ne[2], x->ne[3]);
+        rank = 2;
+    } else if (node.op == "linear") {
+        // Weight [in, out] times [in, N] gives [out, N]; quantized weights use ggml's quantized kernels
+        x = ggml_mul_mat(ctx, model_->get_tensor(node.output + ".weight"), x);
+        if (struct ggml_tensor* bias = model_->get_tensor(node.output + ".bias", false)) {
+            x = ggml_add(ctx, x, bias);
+        }
+        rank = 2;
+    } else if (node.op == "softmax") {
+        x = ggml_soft_max(ctx, x);
+    } else {
+        throw ModelLoadException("Unsupported GGML graph op: " + node.op);
+    }
+    ggml_set_name(x, node.output.c_str());
+    return x;
+}
+
+void GGMLInfer::build_graph(int64_t batch)
+{
+    // Graph metadata only (no_alloc): its size follows from the number of nodes in the model
+    const size_t graph_size = std::max<size_t>(GGML_DEFAULT_GRAPH_SIZE, nodes_.size() * kTensorsPerNode);
+    if (ctx_) {
+        ggml_free(ctx_);
+    }
+    ggml_init_params params = {
+        .mem_size = ggml_tensor_overhead() * graph_size + ggml_graph_overhead_custom(graph_size, false),
+        .mem_buffer = nullptr,
+        .no_alloc = true
+    };
+    ctx_ = ggml_init(params);
+    if (!ctx_) {
+        throw std::runtime_error("Failed to initialize GGML context");
+    }
+    output_tensors_.clear();
+    output_ranks_.clear();
+
+    // Input [W, H, C, N] is the memory order of an NCHW blob
+    input_tensor_ = ggml_new_tensor_4d(ctx_, GGML_TYPE_F32, input_shape_[2], input_shape_[1], input_shape_[0], batch);
+    ggml_set_name(input_tensor_, "input");
+    ggml_set_input(input_tensor_);
+
+    std::unordered_map<std::string, std::pair<struct ggml_tensor*, int>> values{{"input", {input_tensor_, 4}}};
+    for (const auto& node : nodes_) {
+        std::vector<struct ggml_tensor*> inputs;
+        int rank = 0;
+        for (const auto& name : node.inputs) {
+            const auto it = values.find(name);
+            if (it == values.end()) {
+                throw ModelLoadException("Node " + node.output + " reads undefined value " + name);
+            }
+            inputs.push_back(it->second.first);
+            rank = std::max(rank, it->second.second);
+        }
+        struct ggml_tensor* output = build_node(ctx_, node, inputs, rank);
+        values[node.output] = {output, rank};
+    }
+
+    graph_ = ggml_new_graph_custom(ctx_, graph_size, false);
+    for (const auto& name : output_names_) {
+        const auto it = values.find(name);
+        if (it == values.end()) {
+            throw ModelLoadException("Graph output not produced by any node: " + name);
+        }
+        ggml_set_output(it->second.first);
+        output_tensors_.push_back(it->second.first);
+        output_ranks_.push_back(it->second.second);
+        ggml_build_forward_expand(graph_, it->second.first);
+    }
+
+    // The first graph is measured to size the compute buffer; later graphs reuse it, intermediate
+    // tensors sharing memory once their consumers have run
+    if (graph_batch_ == 0 && !ggml_gallocr_reserve(allocr_, graph_)) {
+        throw ModelLoadException("Failed to reserve the compute buffer");
+    }
+    if (!ggml_gallocr_alloc_graph(allocr_, graph_)) {
+        throw std::runtime_error("Failed to allocate the compute graph");
+    }
+    graph_batch_ = batch;
+    LOG(INFO) << "GGML graph for batch " << batch << ": " << ggml_graph_n_nodes(graph_) << " nodes, "
+              << ggml_gallocr_get_buffer_size(allocr_, 0) / (1024 * 1024) << " MB compute buffer";
 }
 
 void GGMLInfer::setup_input_output_tensors(const std::vector<std::vector<int64_t>>& input_sizes)
 {
-    if (input_sizes.empty()) {
-        throw std::runtime_error("Input sizes must be specified for GGML backend");
-    }
-    
-    // Setup input tensors
-    for (size_t i = 0; i < input_sizes.size(); i++) {
-        const auto& shape = input_sizes[i];
-        if (shape.size() != 4) {
-            throw std::runtime_error("GGML expects 4D input tensors (batch, height, width, channels)");
-        }
-        
-        std::string input_name = "input" + std::to_string(i + 1);
-        model_info_.addInput(input_name, shape, batch_size_);
-    }
-    
-    // Setup output tensors (placeholder - would be determined from actual model)
-    std::vector<int64_t> output_shape = {static_cast<int64_t>(batch_size_), 1000}; // Example: 1000 classes
-    model_info_.addOutput("output", output_shape, batch_size_);
-    
-    output_names_.push_back("output");
+    // The model carries its input shape; an explicit size, CHW or (N, H, W, C), must agree with it
+    for (const auto& shape : input_sizes) {
+        const bool chw = shape.size() == 3 && shape == input_shape_;
+        const bool nhwc = shape.size() == 4 && shape[1] == input_shape_[1] && shape[2] == input_shape_[2] && shape[3] == input_shape_[0];
+        if (!chw && !nhwc) {
+            throw ModelLoadException("Input size does not match the model input shape");
+        }
+    }
+    model_info_.addInput("input", input_shape_, batch_size_);
+
+    build_graph(static_cast<int64_t>(batch_size_));
+
+    // Output shapes excluding batch size
+    for (size_t i = 0; i < output_tensors_.size(); ++i) {
+        std::vector<int64_t> shape = get_tensor_shape(output_tensors_[i], output_ranks_[i]);
+        shape.erase(shape.begin());
+        model_info_.addOutput(output_names_[i], shape, batch_size_);
+    }
 }
 
-std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> 
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>
 GGMLInfer::get_infer_results(const cv::Mat& input_blob)
 {
     if (!model_loaded_) {
         throw std::runtime_error("Model not loaded");
     }
-    
+
     start_timer();
-    
+
     try {
-        // Convert OpenCV Mat to GGML tensor
-        std::vector<float> input_data = blob2vec(input_blob);
-        
-        // Copy data to input tensor
-        size_t tensor_size = input_tensor_->ne[0] * input_tensor_->ne[1] * input_tensor_->ne[2] * input_tensor_->ne[3];
-        LOG(INFO) << "Tensor dimensions: " << input_tensor_->ne[0] << "x" << input_tensor_->ne[1] << "x" << input_tensor_->ne[2] << "x" << input_tensor_->ne[3];
-        LOG(INFO) << "Tensor size: " << tensor_size << ", Input data size: " << input_data.size();
-        
-        if (tensor_size != input_data.size()) {
-            throw std::runtime_error("Input data size mismatch: tensor=" + std::to_string(tensor_size) + ", data=" + std::to_string(input_data.size()));
-        }
-        
-        memcpy(input_tensor_->data, input_data.data(), input_data.size() * sizeof(float));
-        
-        // Execute the graph (if backend is available)
-        if (backend_) {
-            ggml_backend_graph_compute(backend_, graph_);
-        } else {
-            LOG(WARNING) << "No backend available, skipping graph computation";
+        if (input_blob.depth() != CV_32F || !input_blob.isContinuous()) {
+            throw std::runtime_error("GGML expects a continuous float NCHW blob");
+        }
+        const int64_t batch = input_blob.dims == 4 ? input_blob.size[0] : 1;
+        if (batch != graph_batch_) {
+            build_graph(batch);
         }
-        
-        // Get output tensors
+        const size_t tensor_size = ggml_nelements(input_tensor_);
+        if (tensor_size != input_blob.total() * input_blob.channels()) {
+            throw std::runtime_error("Input data size mismatch: tensor=" + std::to_string(tensor_size) + ", data=" + std::to_string(input_blob.total() * input_blob.channels()));
+        }
+
+        ggml_backend_tensor_set(input_tensor_, input_blob.ptr<float>(), 0, ggml_nbytes(input_tensor_));
+
+        if (ggml_backend_graph_compute(backend_, graph_) != GGML_STATUS_SUCCESS) {
+            throw std::runtime_error("GGML graph computation failed");
+        }
+
         std::vector<std::vector<TensorElement>> outputs;
         std::vector<std::vector<int64_t>> shapes;
-        
-        // For demonstration, we'll create a simple output
-        // In practice, you would iterate through the actual output tensors
-        std::vector<TensorElement> output_data(1000, 0.0f); // Placeholder
-        outputs.push_back(output_data);
-        
-        std::vector<int64_t> output_shape = {static_cast<int64_t>(batch_size_), 1000};
-        shapes.push_back(output_shape);
-        
+        for (size_t i = 0; i < output_tensors_.size(); ++i) {
+            outputs.push_back(tensor_to_vector(output_tensors_[i]));
+            shapes.push_back(get_tensor_shape(output_tensors_[i], output_ranks_[i]));
+        }
+
         end_timer();
-        
+
         return std::make_tuple(outputs, shapes);
-        
+
     } catch (const std::exception& e) {
         end_timer();
         throw InferenceExecutionException(e.what());
     }
 }
 
+size_t GGMLInfer::get_memory_usage_mb() const noexcept
+{
+    size_t bytes = model_ ? model_->size_bytes() : 0;
+    if (allocr_) {
+        bytes += ggml_gallocr_get_buffer_size(allocr_, 0);
+    }
+    return bytes / (1024 * 1024);
+}
+
 std::vector<TensorElement> GGMLInfer::tensor_to_vector(struct ggml_tensor* tensor)
 {
-    std::vector<TensorElement> result;
-    size_t total_elements = ggml_nelements(tensor);
-    result.reserve(total_elements);
-    
-    float* data = static_cast<float*>(tensor->data);
-    for (size_t i = 0; i < total_elements; ++i) {
-        result.push_back(data[i]);
-    }
-    
-    return result;
+    std::vector<float> data(ggml_nelements(tensor));
+    ggml_backend_tensor_get(tensor, data.data(), 0, data.size() * sizeof(float));
+    return std::vector<TensorElement>(data.begin(), data.end());
 }
 
-std::vector<int64_t> GGMLInfer::get_tensor_shape(struct ggml_tensor* tensor)
+std::vector<int64_t> GGMLInfer::get_tensor_shape(struct ggml_tensor* tensor, int rank)
 {
+    // ggml orders dimensions innermost first
     std::vector<int64_t> shape;
-    for (int i = 0; i < GGML_MAX_DIMS; ++i) {
-        if (tensor->ne[i] > 1) {
-            shape.push_back(tensor->ne[i]);
-        }
+    for (int i = rank - 1; i >= 0; --i) {
+        shape.push_back(tensor->ne[i]);
     }
     return shape;
 }
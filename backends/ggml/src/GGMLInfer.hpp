@@ -1,33 +1,73 @@
 #pragma once
 #include "InferenceInterface.hpp"
-#include <ggml.h>
-#include <ggml-backend.h>
+#include "GGUFModel.hpp"
+#include <ggml-alloc.h>
+#include <memory>
+#include <unordered_map>
 
+// GGUF models written by scripts/convert_onnx_to_ggml.py and scripts/convert_resnet18_to_ggml.py
+// (general.architecture "cnn"). The forward graph is stored as metadata:
+//   cnn.input_shape  [C, H, W]
+//   cnn.graph        one node per string: "<op> <output> <input>[,<input>] [key=value ...]"
+//   cnn.outputs      names of the graph outputs
+// The network input is named "input", and a node's parameters are the tensors "<output>.weight"
+// and "<output>.bias". Ops: conv2d (batchnorm folded in), affine, relu, maxpool2d, avgpool2d,
+// global_avgpool, add, flatten, linear, softmax.
+// conv2d and linear weights may be quantized (Q8_0, Q4_K, any type ggml's CPU matmul supports);
+// a quantized conv2d kernel is a [KW*KH*IC, OC] matrix with the kernel size in the kw/kh params.
 class GGMLInfer : public InferenceInterface
 {
 private:
+    struct GGMLNode {
+        std::string op;
+        std::string output;
+        std::vector<std::string> inputs;
+        std::unordered_map<std::string, int> params;
+    };
+
     struct ggml_context* ctx_;
     struct ggml_backend* backend_;
     struct ggml_cgraph* graph_;
     struct ggml_tensor* input_tensor_;
     std::vector<struct ggml_tensor*> output_tensors_;
+    std::vector<int> output_ranks_;
     std::vector<std::string> output_names_;
     bool model_loaded_;
-    
+
+    std::unique_ptr<GGUFModel> model_;
+    // Intermediate tensors are placed by the graph allocator in one compute buffer, sized once by
+    // measuring the graph and reused by every call (and grown only if a larger batch needs it)
+    ggml_gallocr_t allocr_;
+    struct ggml_threadpool* threadpool_;
+    int64_t graph_batch_;
+
+    std::vector<int64_t> input_shape_;  // C, H, W
+    std::vector<GGMLNode> nodes_;
+
 public:
-    GGMLInfer(const std::string& model_path, 
-        bool use_gpu = false, 
-        size_t batch_size = 1, 
-        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>());
+    GGMLInfer(const std::string& model_path,
+        bool use_gpu = false,
+        size_t batch_size = 1,
+        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>(),
+        const GGMLOptions& options = GGMLOptions());
 
     ~GGMLInfer();
 
+    // Takes an NCHW blob; a batch size other than the current one rebuilds the graph
     std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
 
+    // Weights plus compute buffer
+    size_t get_memory_usage_mb() const noexcept override;
+
 private:
     void load_model(const std::string& model_path);
-    void setup_backend(bool use_gpu);
+    void release();
+    void parse_graph();
+    void build_graph(int64_t batch);
+    struct ggml_tensor* build_node(struct ggml_context* ctx, const GGMLNode& node,
+        const std::vector<struct ggml_tensor*>& inputs, int& rank);
+    void setup_backend(bool use_gpu, const GGMLOptions& options);
     void setup_input_output_tensors(const std::vector<std::vector<int64_t>>& input_sizes);
     std::vector<TensorElement> tensor_to_vector(struct ggml_tensor* tensor);
-    std::vector<int64_t> get_tensor_shape(struct ggml_tensor* tensor);
+    std::vector<int64_t> get_tensor_shape(struct ggml_tensor* tensor, int rank);
 };
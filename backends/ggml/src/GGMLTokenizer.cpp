@@ -0,0 +1,290 @@
+#include "GGMLTokenizer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace {
+
+const std::string kSpaceMarker = "\xE2\x96\x81";  // U+2581, SentencePiece's word boundary
+
+constexpr int64_t kTokenTypeControl = 3;
+constexpr int64_t kTokenTypeByte = 6;
+
+size_t utf8_length(unsigned char lead)
+{
+    if ((lead & 0x80) == 0x00) return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+std::vector<std::string> utf8_chars(const std::string& text)
+{
+    std::vector<std::string> chars;
+    for (size_t i = 0; i < text.size();) {
+        const size_t length = std::min(utf8_length(static_cast<unsigned char>(text[i])), text.size() - i);
+        chars.push_back(text.substr(i, length));
+        i += length;
+    }
+    return chars;
+}
+
+std::string utf8_encode(uint32_t codepoint)
+{
+    std::string out;
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else {
+        // Byte-level BPE code points stay below 0x800
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    return out;
+}
+
+// GPT-2's reversible byte to printable code point mapping
+struct ByteUnicode {
+    std::string byte_to_char[256];
+    std::unordered_map<std::string, unsigned char> char_to_byte;
+
+    ByteUnicode()
+    {
+        uint32_t next = 256;
+        for (int b = 0; b < 256; ++b) {
+            const bool printable = (b >= 33 && b <= 126) || (b >= 161 && b <= 172) || (b >= 174 && b <= 255);
+            byte_to_char[b] = utf8_encode(printable ? b : next++);
+            char_to_byte[byte_to_char[b]] = static_cast<unsigned char>(b);
+        }
+    }
+};
+
+const ByteUnicode& byte_unicode()
+{
+    static const ByteUnicode table;
+    return table;
+}
+
+// SentencePiece byte fallback token "<0xXX>"
+bool parse_byte_token(const std::string& text, char& byte)
+{
+    if (text.size() != 6 || text.compare(0, 3, "<0x") != 0 || text[5] != '>'
+        || !std::isxdigit(static_cast<unsigned char>(text[3])) || !std::isxdigit(static_cast<unsigned char>(text[4]))) {
+        return false;
+    }
+    byte = static_cast<char>(std::stoi(text.substr(3, 2), nullptr, 16));
+    return true;
+}
+
+enum CharClass { kLetter, kDigit, kSpace, kOther };
+
+CharClass classify(unsigned char c)
+{
+    if (std::isalpha(c) || c >= 0x80) return kLetter;
+    if (std::isdigit(c)) return kDigit;
+    if (std::isspace(c)) return kSpace;
+    return kOther;
+}
+
+} // namespace
+
+GGMLTokenizer::GGMLTokenizer(const GGUFModel& model)
+{
+    const std::string type = model.get_string("tokenizer.ggml.model");
+    if (type == "llama") {
+        type_ = Type::SentencePiece;
+    } else if (type == "gpt2") {
+        type_ = Type::BytePairEncoding;
+    } else {
+        throw ModelLoadException("Unsupported tokenizer '" + type + "', expected llama or gpt2");
+    }
+
+    tokens_ = model.get_string_array("tokenizer.ggml.tokens");
+    if (model.has_key("tokenizer.ggml.scores")) {
+        scores_ = model.get_float_array("tokenizer.ggml.scores");
+    }
+    if (model.has_key("tokenizer.ggml.token_type")) {
+        token_types_ = model.get_int_array("tokenizer.ggml.token_type");
+    }
+    scores_.resize(tokens_.size(), 0.0f);
+    token_types_.resize(tokens_.size(), 1);
+    for (size_t i = 0; i < tokens_.size(); ++i) {
+        ids_.emplace(tokens_[i], static_cast<int32_t>(i));
+        char byte;
+        if (type_ == Type::SentencePiece && token_types_[i] == kTokenTypeByte && !parse_byte_token(tokens_[i], byte)) {
+            throw ModelLoadException("Malformed byte token '" + tokens_[i] + "' (id " + std::to_string(i) + "), expected <0xXX>");
+        }
+    }
+    if (type_ == Type::BytePairEncoding) {
+        const auto merges = model.get_string_array("tokenizer.ggml.merges");
+        for (size_t i = 0; i < merges.size(); ++i) {
+            merge_ranks_.emplace(merges[i], static_cast<int>(i));
+        }
+    }
+
+    bos_ = static_cast<int32_t>(model.get_int("tokenizer.ggml.bos_token_id", -1));
+    eos_ = static_cast<int32_t>(model.get_int("tokenizer.ggml.eos_token_id", -1));
+    eot_ = static_cast<int32_t>(model.get_int("tokenizer.ggml.eot_token_id", -1));
+    add_bos_ = model.get_bool("tokenizer.ggml.add_bos_token", type_ == Type::SentencePiece) && bos_ >= 0;
+    add_space_prefix_ = model.get_bool("tokenizer.ggml.add_space_prefix", type_ == Type::SentencePiece);
+}
+
+std::vector<std::string> GGMLTokenizer::merge(std::vector<std::string> symbols) const
+{
+    // Repeatedly merge the best adjacent pair: highest vocabulary score for SentencePiece, lowest
+    // merge rank for BPE. Prompts are short, so the quadratic scan is fine.
+    while (symbols.size() > 1) {
+        size_t best = symbols.size();
+        float best_priority = 0.0f;
+        for (size_t i = 0; i + 1 < symbols.size(); ++i) {
+            float priority;
+            if (type_ == Type::SentencePiece) {
+                const auto it = ids_.find(symbols[i] + symbols[i + 1]);
+                if (it == ids_.end()) {
+                    continue;
+                }
+                priority = scores_[it->second];
+            } else {
+                const auto it = merge_ranks_.find(symbols[i] + " " + symbols[i + 1]);
+                if (it == merge_ranks_.end()) {
+                    continue;
+                }
+                priority = -static_cast<float>(it->second);
+            }
+            if (best == symbols.size() || priority > best_priority) {
+                best = i;
+                best_priority = priority;
+            }
+        }
+        if (best == symbols.size()) {
+            break;
+        }
+        symbols[best] += symbols[best + 1];
+        symbols.erase(symbols.begin() + best + 1);
+    }
+    return symbols;
+}
+
+void GGMLTokenizer::encode_sentencepiece(const std::string& text, std::vector<int32_t>& ids) const
+{
+    std::string normalized = add_space_prefix_ ? kSpaceMarker : std::string();
+    for (char c : text) {
+        normalized += c == ' ' ? kSpaceMarker : std::string(1, c);
+    }
+    for (const auto& symbol : merge(utf8_chars(normalized))) {
+        const auto it = ids_.find(symbol);
+        if (it != ids_.end()) {
+            ids.push_back(it->second);
+            continue;
+        }
+        // Byte fallback
+        for (unsigned char byte : symbol) {
+            char name[8];
+            std::snprintf(name, sizeof(name), "<0x%02X>", byte);
+            const auto byte_it = ids_.find(name);
+            if (byte_it != ids_.end()) {
+                ids.push_back(byte_it->second);
+            }
+        }
+    }
+}
+
+void GGMLTokenizer::encode_bpe(const std::string& text, std::vector<int32_t>& ids) const
+{
+    const auto& table = byte_unicode();
+    const size_t n = text.size();
+    for (size_t i = 0; i < n;) {
+        const size_t start = i;
+        // A single space belongs to the word that follows it
+        if (text[i] == ' ' && i + 1 < n && classify(text[i + 1]) != kSpace) {
+            ++i;
+        }
+        const CharClass cls = classify(text[i]);
+        if (cls == kSpace) {
+            size_t end = i;
+            while (end < n && classify(text[end]) == kSpace) {
+                ++end;
+            }
+            if (end < n && end - i > 1 && text[end - 1] == ' ') {
+                --end;
+            }
+            i = end;
+        } else {
+            while (i < n && classify(text[i]) == cls) {
+                ++i;
+            }
+        }
+
+        std::vector<std::string> symbols;
+        for (size_t j = start; j < i; ++j) {
+            symbols.push_back(table.byte_to_char[static_cast<unsigned char>(text[j])]);
+        }
+        for (const auto& symbol : merge(std::move(symbols))) {
+            const auto it = ids_.find(symbol);
+            if (it != ids_.end()) {
+                ids.push_back(it->second);
+            }
+        }
+    }
+}
+
+std::vector<int32_t> GGMLTokenizer::encode(const std::string& text, bool add_bos) const
+{
+    std::vector<int32_t> ids;
+    if (add_bos && add_bos_) {
+        ids.push_back(bos_);
+    }
+    if (text.empty()) {
+        return ids;
+    }
+    if (type_ == Type::SentencePiece) {
+        encode_sentencepiece(text, ids);
+    } else {
+        encode_bpe(text, ids);
+    }
+    return ids;
+}
+
+std::string GGMLTokenizer::piece(int32_t token) const
+{
+    if (token < 0 || static_cast<size_t>(token) >= tokens_.size() || token_types_[token] == kTokenTypeControl) {
+        return std::string();
+    }
+    const std::string& text = tokens_[token];
+    if (type_ == Type::SentencePiece) {
+        char byte;
+        if (token_types_[token] == kTokenTypeByte && parse_byte_token(text, byte)) {
+            return std::string(1, byte);
+        }
+        std::string out;
+        for (size_t pos = 0; pos < text.size();) {
+            if (text.compare(pos, kSpaceMarker.size(), kSpaceMarker) == 0) {
+                out += ' ';
+                pos += kSpaceMarker.size();
+            } else {
+                out += text[pos++];
+            }
+        }
+        return out;
+    }
+    const auto& table = byte_unicode();
+    std::string out;
+    for (const auto& c : utf8_chars(text)) {
+        const auto it = table.char_to_byte.find(c);
+        out += it != table.char_to_byte.end() ? std::string(1, static_cast<char>(it->second)) : c;
+    }
+    return out;
+}
+
+std::string GGMLTokenizer::decode(const std::vector<int32_t>& tokens) const
+{
+    std::string text;
+    for (int32_t token : tokens) {
+        text += piece(token);
+    }
+    // Drop the space SentencePiece prefixed to the first word
+    if (type_ == Type::SentencePiece && add_space_prefix_ && !text.empty() && text[0] == ' ') {
+        text.erase(0, 1);
+    }
+    return text;
+}
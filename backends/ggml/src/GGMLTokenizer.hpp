@@ -0,0 +1,42 @@
+#pragma once
+#include "GGUFModel.hpp"
+#include <unordered_map>
+
+// Tokenizer stored in GGUF metadata (tokenizer.ggml.*). "llama" vocabularies are SentencePiece:
+// symbols merge by vocabulary score and unknown bytes become <0xXX> tokens. "gpt2" vocabularies
+// are byte-level BPE: symbols merge by rank from tokenizer.ggml.merges, after a simplified
+// pre-tokenizer that splits letter, digit, punctuation and whitespace runs.
+class GGMLTokenizer
+{
+public:
+    explicit GGMLTokenizer(const GGUFModel& model);
+
+    std::vector<int32_t> encode(const std::string& text, bool add_bos = true) const;
+    std::string decode(const std::vector<int32_t>& tokens) const;
+
+    int32_t bos() const { return bos_; }
+    int32_t eos() const { return eos_; }
+    size_t vocab_size() const { return tokens_.size(); }
+    // End of sequence or end of turn
+    bool is_end_of_generation(int32_t token) const { return token == eos_ || token == eot_; }
+
+private:
+    enum class Type { SentencePiece, BytePairEncoding };
+
+    std::vector<std::string> merge(std::vector<std::string> symbols) const;
+    void encode_sentencepiece(const std::string& text, std::vector<int32_t>& ids) const;
+    void encode_bpe(const std::string& text, std::vector<int32_t>& ids) const;
+    std::string piece(int32_t token) const;
+
+    Type type_;
+    std::vector<std::string> tokens_;
+    std::vector<float> scores_;
+    std::vector<int64_t> token_types_;
+    std::unordered_map<std::string, int32_t> ids_;
+    std::unordered_map<std::string, int> merge_ranks_;  // "left right" -> rank, BPE only
+    int32_t bos_;
+    int32_t eos_;
+    int32_t eot_;
+    bool add_bos_;
+    bool add_space_prefix_;
+};
@@ -0,0 +1,222 @@
+#include "GGUFModel.hpp"
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+ggml_backend_t create_cpu_backend(const GGMLOptions& options, struct ggml_threadpool** threadpool)
+{
+    ggml_backend_t backend = ggml_backend_cpu_init();
+    if (!backend) {
+        throw std::runtime_error("Failed to initialize GGML backend");
+    }
+
+    const int num_threads = options.num_threads > 0 ? options.num_threads
+        : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    struct ggml_threadpool_params threadpool_params = ggml_threadpool_params_default(num_threads);
+    threadpool_params.poll = static_cast<uint32_t>(std::clamp(options.poll, 0, 100));
+    *threadpool = ggml_threadpool_new(&threadpool_params);
+    if (!*threadpool) {
+        ggml_backend_free(backend);
+        throw std::runtime_error("Failed to create the GGML threadpool");
+    }
+    ggml_backend_cpu_set_n_threads(backend, num_threads);
+    ggml_backend_cpu_set_threadpool(backend, *threadpool);
+    LOG(INFO) << "GGML CPU backend using " << num_threads << " threads";
+    return backend;
+}
+
+GGUFModel::GGUFModel(const std::string& path, ggml_backend_t backend)
+{
+    // Tensor metadata goes into ctx_, the data is read below into a backend buffer
+    gguf_init_params params = {
+        .no_alloc = true,
+        .ctx = &ctx_
+    };
+    gguf_ = gguf_init_from_file(path.c_str(), params);
+    if (!gguf_) {
+        throw ModelLoadException("Cannot read GGUF model: " + path);
+    }
+
+    try {
+        buffer_ = ggml_backend_alloc_ctx_tensors(ctx_, backend);
+        if (!buffer_) {
+            throw ModelLoadException("Failed to allocate the weights buffer");
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw ModelLoadException("Cannot open model file: " + path);
+        }
+        const size_t data_offset = gguf_get_data_offset(gguf_);
+        const bool host_buffer = ggml_backend_buffer_is_host(buffer_);
+        std::vector<char> staging;
+        for (int64_t i = 0; i < gguf_get_n_tensors(gguf_); ++i) {
+            struct ggml_tensor* tensor = ggml_get_tensor(ctx_, gguf_get_tensor_name(gguf_, i));
+            if (ggml_is_quantized(tensor->type)) {
+                ++quantized_tensors_;
+            }
+            const size_t size = ggml_nbytes(tensor);
+            file.seekg(data_offset + gguf_get_tensor_offset(gguf_, i));
+            if (host_buffer) {
+                file.read(static_cast<char*>(tensor->data), size);
+            } else {
+                staging.resize(size);
+                file.read(staging.data(), size);
+                ggml_backend_tensor_set(tensor, staging.data(), 0, size);
+            }
+            if (!file) {
+                throw ModelLoadException(std::string("Truncated tensor data for ") + ggml_get_name(tensor));
+            }
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+GGUFModel::~GGUFModel()
+{
+    release();
+}
+
+void GGUFModel::release()
+{
+    if (buffer_) {
+        ggml_backend_buffer_free(buffer_);
+        buffer_ = nullptr;
+    }
+    if (ctx_) {
+        ggml_free(ctx_);
+        ctx_ = nullptr;
+    }
+    if (gguf_) {
+        gguf_free(gguf_);
+        gguf_ = nullptr;
+    }
+}
+
+int64_t GGUFModel::find_key(const std::string& key) const
+{
+    const int64_t id = gguf_find_key(gguf_, key.c_str());
+    if (id < 0) {
+        throw ModelLoadException("GGUF metadata key not found: " + key);
+    }
+    return id;
+}
+
+int64_t GGUFModel::find_array(const std::string& key) const
+{
+    const int64_t id = find_key(key);
+    if (gguf_get_kv_type(gguf_, id) != GGUF_TYPE_ARRAY) {
+        throw ModelLoadException("GGUF metadata key " + key + " is not an array");
+    }
+    return id;
+}
+
+bool GGUFModel::has_key(const std::string& key) const
+{
+    return gguf_find_key(gguf_, key.c_str()) >= 0;
+}
+
+int64_t GGUFModel::get_int(const std::string& key) const
+{
+    const int64_t id = find_key(key);
+    switch (gguf_get_kv_type(gguf_, id)) {
+        case GGUF_TYPE_UINT8:  return gguf_get_val_u8(gguf_, id);
+        case GGUF_TYPE_INT8:   return gguf_get_val_i8(gguf_, id);
+        case GGUF_TYPE_UINT16: return gguf_get_val_u16(gguf_, id);
+        case GGUF_TYPE_INT16:  return gguf_get_val_i16(gguf_, id);
+        case GGUF_TYPE_UINT32: return gguf_get_val_u32(gguf_, id);
+        case GGUF_TYPE_INT32:  return gguf_get_val_i32(gguf_, id);
+        case GGUF_TYPE_UINT64: return static_cast<int64_t>(gguf_get_val_u64(gguf_, id));
+        case GGUF_TYPE_INT64:  return gguf_get_val_i64(gguf_, id);
+        default: throw ModelLoadException("GGUF metadata key " + key + " is not an integer");
+    }
+}
+
+int64_t GGUFModel::get_int(const std::string& key, int64_t fallback) const
+{
+    return has_key(key) ? get_int(key) : fallback;
+}
+
+float GGUFModel::get_float(const std::string& key, float fallback) const
+{
+    if (!has_key(key)) {
+        return fallback;
+    }
+    const int64_t id = find_key(key);
+    switch (gguf_get_kv_type(gguf_, id)) {
+        case GGUF_TYPE_FLOAT32: return gguf_get_val_f32(gguf_, id);
+        case GGUF_TYPE_FLOAT64: return static_cast<float>(gguf_get_val_f64(gguf_, id));
+        default: throw ModelLoadException("GGUF metadata key " + key + " is not a float");
+    }
+}
+
+bool GGUFModel::get_bool(const std::string& key, bool fallback) const
+{
+    if (!has_key(key)) {
+        return fallback;
+    }
+    const int64_t id = find_key(key);
+    if (gguf_get_kv_type(gguf_, id) != GGUF_TYPE_BOOL) {
+        throw ModelLoadException("GGUF metadata key " + key + " is not a bool");
+    }
+    return gguf_get_val_bool(gguf_, id);
+}
+
+std::string GGUFModel::get_string(const std::string& key) const
+{
+    const int64_t id = find_key(key);
+    if (gguf_get_kv_type(gguf_, id) != GGUF_TYPE_STRING) {
+        throw ModelLoadException("GGUF metadata key " + key + " is not a string");
+    }
+    return gguf_get_val_str(gguf_, id);
+}
+
+std::vector<int64_t> GGUFModel::get_int_array(const std::string& key) const
+{
+    const int64_t id = find_array(key);
+    const size_t n = gguf_get_arr_n(gguf_, id);
+    const void* data = gguf_get_arr_data(gguf_, id);
+    std::vector<int64_t> values(n);
+    switch (gguf_get_arr_type(gguf_, id)) {
+        case GGUF_TYPE_INT32:  std::copy_n(static_cast<const int32_t*>(data), n, values.begin()); break;
+        case GGUF_TYPE_UINT32: std::copy_n(static_cast<const uint32_t*>(data), n, values.begin()); break;
+        case GGUF_TYPE_INT64:  std::copy_n(static_cast<const int64_t*>(data), n, values.begin()); break;
+        case GGUF_TYPE_UINT64: std::copy_n(static_cast<const uint64_t*>(data), n, values.begin()); break;
+        default: throw ModelLoadException("GGUF metadata key " + key + " is not an integer array");
+    }
+    return values;
+}
+
+std::vector<float> GGUFModel::get_float_array(const std::string& key) const
+{
+    const int64_t id = find_array(key);
+    if (gguf_get_arr_type(gguf_, id) != GGUF_TYPE_FLOAT32) {
+        throw ModelLoadException("GGUF metadata key " + key + " is not a float array");
+    }
+    const float* data = static_cast<const float*>(gguf_get_arr_data(gguf_, id));
+    return std::vector<float>(data, data + gguf_get_arr_n(gguf_, id));
+}
+
+std::vector<std::string> GGUFModel::get_string_array(const std::string& key) const
+{
+    const int64_t id = find_array(key);
+    if (gguf_get_arr_type(gguf_, id) != GGUF_TYPE_STRING) {
+        throw ModelLoadException("GGUF metadata key " + key + " is not a string array");
+    }
+    std::vector<std::string> values;
+    for (size_t i = 0; i < gguf_get_arr_n(gguf_, id); ++i) {
+        values.emplace_back(gguf_get_arr_str(gguf_, id, i));
+    }
+    return values;
+}
+
+struct ggml_tensor* GGUFModel::get_tensor(const std::string& name, bool required) const
+{
+    struct ggml_tensor* tensor = ggml_get_tensor(ctx_, name.c_str());
+    if (!tensor && required) {
+        throw ModelLoadException("Missing weight tensor: " + name);
+    }
+    return tensor;
+}
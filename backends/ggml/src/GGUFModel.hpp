@@ -0,0 +1,59 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include <ggml.h>
+#include <ggml-backend.h>
+#include <ggml-cpu.h>
+#include <gguf.h>
+
+struct GGMLOptions {
+    // CPU compute threads, 0 uses every hardware thread. They live in a threadpool kept for the
+    // lifetime of the engine instead of being spawned for each graph computation.
+    int num_threads = 0;
+    // Threadpool polling level between graphs (0-100): 0 sleeps right away, higher values spin
+    // longer for lower latency on back-to-back calls
+    int poll = 50;
+};
+
+// CPU backend computing on a new threadpool, which the caller frees after the backend
+ggml_backend_t create_cpu_backend(const GGMLOptions& options, struct ggml_threadpool** threadpool);
+
+// A GGUF file: its metadata, and its tensors read into one buffer of the given backend
+class GGUFModel
+{
+public:
+    GGUFModel(const std::string& path, ggml_backend_t backend);
+    ~GGUFModel();
+
+    GGUFModel(const GGUFModel&) = delete;
+    GGUFModel& operator=(const GGUFModel&) = delete;
+
+    std::string architecture() const { return get_string("general.architecture"); }
+
+    // Metadata lookups throw ModelLoadException when the key is missing or of another type
+    bool has_key(const std::string& key) const;
+    int64_t get_int(const std::string& key) const;
+    int64_t get_int(const std::string& key, int64_t fallback) const;
+    float get_float(const std::string& key, float fallback) const;
+    bool get_bool(const std::string& key, bool fallback) const;
+    std::string get_string(const std::string& key) const;
+    std::vector<int64_t> get_int_array(const std::string& key) const;
+    std::vector<float> get_float_array(const std::string& key) const;
+    std::vector<std::string> get_string_array(const std::string& key) const;
+
+    struct ggml_tensor* get_tensor(const std::string& name, bool required = true) const;
+
+    size_t size_bytes() const { return ggml_backend_buffer_get_size(buffer_); }
+    int64_t num_tensors() const { return gguf_get_n_tensors(gguf_); }
+    int num_quantized_tensors() const { return quantized_tensors_; }
+
+private:
+    void release();
+    int64_t find_key(const std::string& key) const;
+    // Like find_key, and throws unless the value is an array: the gguf_get_arr_* accessors abort on scalars
+    int64_t find_array(const std::string& key) const;
+
+    struct gguf_context* gguf_ = nullptr;
+    struct ggml_context* ctx_ = nullptr;
+    ggml_backend_buffer_t buffer_ = nullptr;
+    int quantized_tensors_ = 0;
+};
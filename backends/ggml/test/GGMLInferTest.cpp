@@ -1,11 +1,18 @@
 #include <gtest/gtest.h>
 #include "GGMLInfer.hpp"
+#include "GGMLDecoder.hpp"
+#include "GGMLTokenizer.hpp"
 #include <glog/logging.h>
 #include <opencv2/opencv.hpp>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 
 namespace fs = std::filesystem;
 
@@ -172,6 +179,360 @@ TEST_F(GGMLInferTest, GGMLSpecificTest) {
     }
 }
 
+// Test that the graph read from the GGUF file is executed: model info comes from the file
+// and a batch of identical images gives identical, input dependent outputs
+TEST_F(GGMLInferTest, GGUFGraphExecution) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping GGUF graph test - no real model available";
+    }
+
+    const auto model_info = real_infer->get_model_info();
+    ASSERT_EQ(model_info.getInputs()[0].shape, (std::vector<int64_t>{3, 224, 224}));
+    ASSERT_EQ(model_info.getOutputs()[0].shape, (std::vector<int64_t>{1000}));
+
+    cv::Mat zeros = cv::Mat::zeros(224, 224, CV_32FC3);
+    cv::Mat image(224, 224, CV_32FC3);
+    cv::randu(image, cv::Scalar::all(0.f), cv::Scalar::all(1.f));
+
+    auto [zero_outputs, zero_shapes] = real_infer->get_infer_results(cv::dnn::blobFromImage(zeros));
+    auto [outputs, shapes] = real_infer->get_infer_results(cv::dnn::blobFromImage(image));
+    auto [repeat_outputs, repeat_shapes] = real_infer->get_infer_results(cv::dnn::blobFromImage(image));
+
+    ASSERT_EQ(shapes[0], (std::vector<int64_t>{1, 1000}));
+    bool differs = false;
+    for (size_t i = 0; i < outputs[0].size(); ++i) {
+        ASSERT_FLOAT_EQ(std::get<float>(outputs[0][i]), std::get<float>(repeat_outputs[0][i]));
+        differs |= std::get<float>(outputs[0][i]) != std::get<float>(zero_outputs[0][i]);
+    }
+    ASSERT_TRUE(differs) << "Outputs do not depend on the input";
+
+    // A blob of the wrong size is rejected
+    cv::Mat small = cv::dnn::blobFromImage(cv::Mat::zeros(112, 112, CV_32FC3));
+    EXPECT_THROW(real_infer->get_infer_results(small), InferenceExecutionException);
+}
+
+// Test the threadpool and the reused compute buffer: one and four threads give the same results,
+// and a batch of two rebuilds the graph without growing past the measured buffer per image
+TEST_F(GGMLInferTest, ThreadedComputeReuse) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping threaded compute test - no real model available";
+    }
+
+    GGMLOptions single_thread;
+    single_thread.num_threads = 1;
+    GGMLOptions four_threads;
+    four_threads.num_threads = 4;
+    GGMLInfer single(model_path, false, 1, {}, single_thread);
+    GGMLInfer threaded(model_path, false, 1, {}, four_threads);
+
+    cv::Mat image(224, 224, CV_32FC3);
+    cv::randu(image, cv::Scalar::all(0.f), cv::Scalar::all(1.f));
+    const cv::Mat blob = cv::dnn::blobFromImage(image);
+
+    auto [single_outputs, single_shapes] = single.get_infer_results(blob);
+    const size_t memory_mb = threaded.get_memory_usage_mb();
+    for (int i = 0; i < 3; ++i) {
+        auto [outputs, shapes] = threaded.get_infer_results(blob);
+        ASSERT_EQ(shapes, single_shapes);
+        for (size_t j = 0; j < outputs[0].size(); ++j) {
+            ASSERT_NEAR(std::get<float>(outputs[0][j]), std::get<float>(single_outputs[0][j]), 1e-4f);
+        }
+    }
+    // Repeated calls reuse the compute buffer
+    EXPECT_EQ(threaded.get_memory_usage_mb(), memory_mb);
+
+    auto [batch_outputs, batch_shapes] = threaded.get_infer_results(cv::dnn::blobFromImages(std::vector<cv::Mat>{image, image}));
+    ASSERT_EQ(batch_shapes[0], (std::vector<int64_t>{2, 1000}));
+    for (size_t j = 0; j < 1000; ++j) {
+        ASSERT_NEAR(std::get<float>(batch_outputs[0][1000 + j]), std::get<float>(single_outputs[0][j]), 1e-4f);
+    }
+}
+
+// Test quantized models written next to the F32 one (resnet18-q8_0.ggml, resnet18-q4_k.ggml):
+// top-1 must mostly agree with F32 on the same images; footprint and latency are reported
+TEST_F(GGMLInferTest, QuantizedAccuracyAndLatency) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping quantized model test - no real model available";
+    }
+
+    const int num_images = 16;
+    std::vector<cv::Mat> blobs;
+    cv::RNG rng(42);
+    for (int i = 0; i < num_images; ++i) {
+        cv::Mat image(224, 224, CV_32FC3);
+        rng.fill(image, cv::RNG::NORMAL, cv::Scalar::all(0.f), cv::Scalar::all(1.f));
+        cv::GaussianBlur(image, image, cv::Size(9, 9), 0);
+        blobs.push_back(cv::dnn::blobFromImage(image));
+    }
+
+    const auto run = [&blobs](GGMLInfer& infer, std::vector<size_t>& top1) {
+        infer.get_infer_results(blobs[0]);  // Warm-up
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& blob : blobs) {
+            auto [outputs, shapes] = infer.get_infer_results(blob);
+            const auto best = std::max_element(outputs[0].begin(), outputs[0].end(),
+                [](const TensorElement& a, const TensorElement& b) { return std::get<float>(a) < std::get<float>(b); });
+            top1.push_back(std::distance(outputs[0].begin(), best));
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / blobs.size();
+    };
+
+    std::vector<size_t> reference;
+    const double f32_ms = run(*real_infer, reference);
+    const auto f32_bytes = fs::file_size(model_path);
+
+    const fs::path path(model_path);
+    int tested = 0;
+    for (const auto& [type, min_agreement] : {std::make_pair(std::string("q8_0"), 0.9), std::make_pair(std::string("q4_k"), 0.75)}) {
+        const fs::path quantized_path = path.parent_path() / (path.stem().string() + "-" + type + path.extension().string());
+        if (!fs::exists(quantized_path)) {
+            continue;
+        }
+        GGMLInfer quantized(quantized_path.string());
+        std::vector<size_t> top1;
+        const double quantized_ms = run(quantized, top1);
+        const auto agree = std::inner_product(top1.begin(), top1.end(), reference.begin(), 0, std::plus<>(), std::equal_to<>());
+        const double agreement = static_cast<double>(agree) / num_images;
+        std::cout << type << ": top-1 agreement " << agreement << ", " << quantized_ms << " ms vs " << f32_ms
+                  << " ms (F32), " << fs::file_size(quantized_path) << " vs " << f32_bytes << " bytes" << std::endl;
+
+        EXPECT_GE(agreement, min_agreement) << type;
+        EXPECT_LT(fs::file_size(quantized_path), f32_bytes / 2) << type;
+        ++tested;
+    }
+    if (tested == 0) {
+        GTEST_SKIP() << "No quantized model next to " << model_path;
+    }
+}
+
+// Decoder model written by create_test_decoder.py, empty if there is none
+static std::string decoder_model_path()
+{
+    std::ifstream file("decoder_model_path.txt");
+    std::string path;
+    if (file) {
+        std::getline(file, path);
+    }
+    return !path.empty() && fs::exists(path) ? path : std::string();
+}
+
+static float max_abs_diff(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float diff = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, std::abs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+static int32_t argmax(const std::vector<float>& logits)
+{
+    return static_cast<int32_t>(std::max_element(logits.begin(), logits.end()) - logits.begin());
+}
+
+// Test the KV cache: prefilling part of a prompt and stepping through the rest gives the logits
+// of prefilling all of it, and the tokenizer round-trips the text
+TEST(GGMLDecoderTest, CachedStepsMatchPrefill) {
+    const std::string path = decoder_model_path();
+    if (path.empty()) {
+        GTEST_SKIP() << "Skipping decoder test - no decoder model available";
+    }
+
+    GGMLDecoderOptions options;
+    options.max_sequences = 2;
+    GGMLDecoder decoder(path, options);
+
+    const std::string text = "hello world, hello!";
+    const auto tokens = decoder.tokenizer().encode(text);
+    ASSERT_GT(tokens.size(), 4u);
+    EXPECT_EQ(tokens.front(), decoder.tokenizer().bos());
+    EXPECT_EQ(decoder.tokenizer().decode(tokens), text);
+
+    const int full = decoder.new_sequence();
+    const auto expected = decoder.prefill(full, tokens);
+    ASSERT_EQ(expected.size(), static_cast<size_t>(decoder.vocab_size()));
+
+    // A prefill longer than max_batch_tokens runs in several passes with the same result
+    options.max_batch_tokens = 2;
+    GGMLDecoder chunked(path, options);
+    EXPECT_EQ(chunked.max_batch_tokens(), 2);
+    const int split = chunked.new_sequence();
+    EXPECT_LT(max_abs_diff(chunked.prefill(split, tokens), expected), 1e-2f);
+    EXPECT_EQ(chunked.sequence_length(split), static_cast<int>(tokens.size()));
+
+    const int cached = decoder.new_sequence();
+    decoder.prefill(cached, std::vector<int32_t>(tokens.begin(), tokens.end() - 3));
+    std::vector<float> logits;
+    for (auto it = tokens.end() - 3; it != tokens.end(); ++it) {
+        logits = decoder.step({cached}, {*it})[0];
+    }
+    EXPECT_EQ(decoder.sequence_length(cached), static_cast<int>(tokens.size()));
+    EXPECT_LT(max_abs_diff(logits, expected), 1e-2f);
+
+    // Cache regions stay claimed until freed
+    EXPECT_EQ(decoder.new_sequence(), -1);
+    decoder.free_sequence(full);
+    EXPECT_EQ(decoder.new_sequence(), full);
+    EXPECT_EQ(decoder.sequence_length(full), 0);
+}
+
+// Test batched decoding: prompts of different lengths prefilled and stepped together give the
+// logits of each sequence decoded alone
+TEST(GGMLDecoderTest, BatchedStepMatchesSingle) {
+    const std::string path = decoder_model_path();
+    if (path.empty()) {
+        GTEST_SKIP() << "Skipping decoder test - no decoder model available";
+    }
+
+    GGMLDecoderOptions options;
+    options.max_sequences = 3;
+    options.num_threads = 2;
+    GGMLDecoder decoder(path, options);
+
+    const std::vector<std::vector<int32_t>> prompts = {
+        decoder.tokenizer().encode("hello"), decoder.tokenizer().encode("world wide web")};
+    const int a = decoder.new_sequence();
+    const int b = decoder.new_sequence();
+    const auto prefilled = decoder.prefill({a, b}, prompts);
+    const std::vector<int32_t> next = {argmax(prefilled[0]), argmax(prefilled[1])};
+    const auto batched = decoder.step({a, b}, next);
+
+    for (size_t i = 0; i < prompts.size(); ++i) {
+        const int single = decoder.new_sequence();
+        ASSERT_GE(single, 0);
+        std::vector<int32_t> prompt = prompts[i];
+        EXPECT_LT(max_abs_diff(decoder.prefill(single, prompt), prefilled[i]), 1e-2f);
+        prompt.push_back(next[i]);
+        decoder.free_sequence(single);
+        const int again = decoder.new_sequence();
+        EXPECT_LT(max_abs_diff(decoder.prefill(again, prompt), batched[i]), 1e-2f);
+        decoder.free_sequence(again);
+    }
+
+    // A sequence may only appear once per batch, and generation needs a free region
+    EXPECT_THROW(decoder.step({a, a}, {next[0], next[0]}), InferenceExecutionException);
+    EXPECT_NO_THROW(decoder.generate("hello", 8));
+}
+
+// Writes a GGUF file with the given metadata and the tensors add_tensors creates, or one dummy
+// tensor so it loads like a real model
+static void write_test_gguf(const fs::path& path, const std::function<void(gguf_context*)>& set_metadata,
+    const std::function<void(ggml_context*, gguf_context*)>& add_tensors = nullptr)
+{
+    ggml_init_params params = {8 * ggml_tensor_overhead() + 4096, nullptr, false};
+    ggml_context* ctx = ggml_init(params);
+    gguf_context* gguf = gguf_init_empty();
+    set_metadata(gguf);
+    if (add_tensors) {
+        add_tensors(ctx, gguf);
+    } else {
+        ggml_tensor* dummy = ggml_new_tensor_1d(ctx, GGML_TYPE_F32, 1);
+        ggml_set_name(dummy, "dummy");
+        *static_cast<float*>(dummy->data) = 0.f;
+        gguf_add_tensor(gguf, dummy);
+    }
+    gguf_write_to_file(gguf, path.c_str(), false);
+    gguf_free(gguf);
+    ggml_free(ctx);
+}
+
+// Test that malformed metadata fails to load with ModelLoadException naming the culprit
+TEST(GGMLMetadataTest, MalformedMetadataRejected) {
+    const auto graph_path = fs::temp_directory_path() / "ggml_malformed_graph.gguf";
+    write_test_gguf(graph_path, [](gguf_context* gguf) {
+        gguf_set_val_str(gguf, "general.architecture", "cnn");
+        const int32_t input_shape[] = {3, 4, 4};
+        gguf_set_arr_data(gguf, "cnn.input_shape", GGUF_TYPE_INT32, input_shape, 3);
+        const char* graph[] = {"relu out input stride=two"};
+        gguf_set_arr_str(gguf, "cnn.graph", graph, 1);
+        const char* outputs[] = {"out"};
+        gguf_set_arr_str(gguf, "cnn.outputs", outputs, 1);
+    });
+    try {
+        GGMLInfer infer(graph_path.string());
+        ADD_FAILURE() << "Malformed node parameter accepted";
+    } catch (const ModelLoadException& e) {
+        EXPECT_NE(std::string(e.what()).find("stride"), std::string::npos) << e.what();
+    }
+    fs::remove(graph_path);
+
+    // A scalar where an array is expected is reported instead of tripping a ggml assertion
+    const auto scalar_path = fs::temp_directory_path() / "ggml_scalar_shape.gguf";
+    write_test_gguf(scalar_path, [](gguf_context* gguf) {
+        gguf_set_val_str(gguf, "general.architecture", "cnn");
+        gguf_set_val_i32(gguf, "cnn.input_shape", 3);
+        const char* graph[] = {"relu out input"};
+        gguf_set_arr_str(gguf, "cnn.graph", graph, 1);
+        const char* outputs[] = {"out"};
+        gguf_set_arr_str(gguf, "cnn.outputs", outputs, 1);
+    });
+    EXPECT_THROW(GGMLInfer infer(scalar_path.string()), ModelLoadException);
+    fs::remove(scalar_path);
+
+    const auto tokenizer_path = fs::temp_directory_path() / "ggml_malformed_tokenizer.gguf";
+    write_test_gguf(tokenizer_path, [](gguf_context* gguf) {
+        gguf_set_val_str(gguf, "general.architecture", "llama");
+        gguf_set_val_str(gguf, "tokenizer.ggml.model", "llama");
+        const char* tokens[] = {"<unk>", "<0xZZ>"};
+        gguf_set_arr_str(gguf, "tokenizer.ggml.tokens", tokens, 2);
+        const int32_t token_types[] = {2, 6};
+        gguf_set_arr_data(gguf, "tokenizer.ggml.token_type", GGUF_TYPE_INT32, token_types, 2);
+    });
+    ggml_backend_t backend = ggml_backend_cpu_init();
+    {
+        GGUFModel model(tokenizer_path.string(), backend);
+        EXPECT_THROW(GGMLTokenizer tokenizer(model), ModelLoadException);
+    }
+    ggml_backend_free(backend);
+    fs::remove(tokenizer_path);
+}
+
+// Test that an F32 kernel with one input and one output channel, whose [KW, KH, 1, 1] shape has
+// only two dimensions, runs as a plain convolution and not through the quantized im2col path
+TEST(GGMLMetadataTest, SingleChannelF32Convolution) {
+    const auto path = fs::temp_directory_path() / "ggml_single_channel_conv.gguf";
+    const float kernel[9] = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f};
+    write_test_gguf(path, [](gguf_context* gguf) {
+        gguf_set_val_str(gguf, "general.architecture", "cnn");
+        const int32_t input_shape[] = {1, 4, 4};
+        gguf_set_arr_data(gguf, "cnn.input_shape", GGUF_TYPE_INT32, input_shape, 3);
+        const char* graph[] = {"conv2d v1 input pad=1"};
+        gguf_set_arr_str(gguf, "cnn.graph", graph, 1);
+        const char* outputs[] = {"v1"};
+        gguf_set_arr_str(gguf, "cnn.outputs", outputs, 1);
+    }, [&kernel](ggml_context* ctx, gguf_context* gguf) {
+        ggml_tensor* weight = ggml_new_tensor_4d(ctx, GGML_TYPE_F32, 3, 3, 1, 1);
+        ggml_set_name(weight, "v1.weight");
+        std::copy(kernel, kernel + 9, static_cast<float*>(weight->data));
+        gguf_add_tensor(gguf, weight);
+    });
+
+    GGMLInfer infer(path.string());
+    cv::Mat image(4, 4, CV_32F);
+    for (int i = 0; i < 16; ++i) {
+        image.at<float>(i / 4, i % 4) = static_cast<float>(i % 5);
+    }
+    auto [outputs, shapes] = infer.get_infer_results(cv::dnn::blobFromImage(image));
+    ASSERT_EQ(shapes[0], (std::vector<int64_t>{1, 1, 4, 4}));
+
+    // Cross-correlation with zero padding, as in the source framework
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            float expected = 0.f;
+            for (int ky = 0; ky < 3; ++ky) {
+                for (int kx = 0; kx < 3; ++kx) {
+                    const int iy = y + ky - 1, ix = x + kx - 1;
+                    if (iy >= 0 && iy < 4 && ix >= 0 && ix < 4) {
+                        expected += kernel[ky * 3 + kx] * image.at<float>(iy, ix);
+                    }
+                }
+            }
+            EXPECT_NEAR(std::get<float>(outputs[0][y * 4 + x]), expected, 1e-4f) << "at " << x << "," << y;
+        }
+    }
+    fs::remove(path);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
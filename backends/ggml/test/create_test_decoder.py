@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Creates a tiny random decoder-only model for the GGMLDecoder tests.
+Writes a "llama" architecture GGUF (2 layers, grouped query attention, tied embeddings) with a
+SentencePiece vocabulary of characters, a few merges and byte fallback tokens. Its outputs are
+meaningless; the tests compare cached, batched and full forward passes against each other.
+"""
+
+import os
+import sys
+
+import numpy as np
+
+
+def create_test_decoder(output_path):
+    import gguf
+
+    print(f"Creating test GGML decoder at: {output_path}")
+    rng = np.random.default_rng(0)
+
+    space = "▁"
+    tokens = ["<unk>", "<s>", "</s>"] + [f"<0x{b:02X}>" for b in range(256)]
+    types = [2, 3, 3] + [6] * 256
+    pieces = [space] + [chr(c) for c in range(ord("a"), ord("z") + 1)] + list(".,!?")
+    pieces += ["he", "ll", "lo", "wo", "or", "ld", space + "h", space + "w", "hell", "hello", space + "hello", space + "world"]
+    tokens += pieces
+    types += [1] * len(pieces)
+    # Longer pieces win merges
+    scores = [0.0] * 259 + [float(len(p)) for p in pieces]
+
+    n_vocab, n_embd, n_ff, n_layer, n_head, n_head_kv = len(tokens), 64, 128, 2, 4, 2
+    head_dim = n_embd // n_head
+
+    writer = gguf.GGUFWriter(output_path, "llama")
+    writer.add_name("test_decoder")
+    writer.add_context_length(256)
+    writer.add_embedding_length(n_embd)
+    writer.add_block_count(n_layer)
+    writer.add_feed_forward_length(n_ff)
+    writer.add_head_count(n_head)
+    writer.add_head_count_kv(n_head_kv)
+    writer.add_layer_norm_rms_eps(1e-5)
+    writer.add_rope_freq_base(10000.0)
+    writer.add_rope_dimension_count(head_dim)
+    writer.add_tokenizer_model("llama")
+    writer.add_token_list(tokens)
+    writer.add_token_scores(scores)
+    writer.add_token_types(types)
+    writer.add_bos_token_id(1)
+    writer.add_eos_token_id(2)
+
+    def weight(rows, cols):
+        return (rng.standard_normal((rows, cols)) / np.sqrt(cols)).astype(np.float32)
+
+    writer.add_tensor("token_embd.weight", weight(n_vocab, n_embd))
+    writer.add_tensor("output_norm.weight", np.ones(n_embd, dtype=np.float32))
+    for i in range(n_layer):
+        block = f"blk.{i}."
+        writer.add_tensor(block + "attn_norm.weight", np.ones(n_embd, dtype=np.float32))
+        writer.add_tensor(block + "attn_q.weight", weight(n_embd, n_embd))
+        writer.add_tensor(block + "attn_k.weight", weight(n_head_kv * head_dim, n_embd))
+        writer.add_tensor(block + "attn_v.weight", weight(n_head_kv * head_dim, n_embd))
+        writer.add_tensor(block + "attn_output.weight", weight(n_embd, n_embd))
+        writer.add_tensor(block + "ffn_norm.weight", np.ones(n_embd, dtype=np.float32))
+        writer.add_tensor(block + "ffn_gate.weight", weight(n_ff, n_embd))
+        writer.add_tensor(block + "ffn_up.weight", weight(n_ff, n_embd))
+        writer.add_tensor(block + "ffn_down.weight", weight(n_embd, n_ff))
+
+    writer.write_header_to_file()
+    writer.write_kv_data_to_file()
+    writer.write_tensors_to_file()
+    writer.close()
+    print(f"Created test decoder with size: {os.path.getsize(output_path)} bytes")
+    return output_path
+
+
+if __name__ == "__main__":
+    output_path = sys.argv[1] if len(sys.argv) > 1 else "/tmp/test_ggml_decoder.gguf"
+    try:
+        model_path = create_test_decoder(output_path)
+        with open("decoder_model_path.txt", "w") as f:
+            f.write(model_path + "\n")
+        print(f"Decoder path written to decoder_model_path.txt: {model_path}")
+    except Exception as e:
+        print(f"Error creating test decoder: {e}")
+        sys.exit(1)
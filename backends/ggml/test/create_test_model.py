@@ -1,55 +1,54 @@
 #!/usr/bin/env python3
 """
 Simple script to create a test model for GGML backend testing.
-This is a placeholder - in practice, you would convert real models to GGML format.
+Writes a small random CNN (conv, relu, max pooling, global average pooling, linear) as a GGUF
+model in the format GGMLInfer loads, with the 3x224x224 input and 1000 outputs of ResNet-18.
 """
 
-import numpy as np
-import struct
 import os
+import sys
+
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "scripts"))
+from convert_onnx_to_ggml import GGUFGraphWriter
+
 
 def create_simple_ggml_model(output_path):
     """
-    Create a simple placeholder GGML model file.
-    This is just for testing the infrastructure - not a real model.
+    Create a small GGUF model with random weights.
+    This exercises the loading and graph execution paths, its outputs are meaningless.
     """
-    print(f"Creating placeholder GGML model at: {output_path}")
-    
-    # Create a simple binary file that looks like a GGML model
-    # In practice, this would be a real GGML model file
-    with open(output_path, 'wb') as f:
-        # Write a simple header (this is not a real GGML format)
-        f.write(b'GGML')  # Magic number
-        f.write(struct.pack('<I', 1))  # Version
-        f.write(struct.pack('<I', 1000))  # Output size
-        f.write(struct.pack('<I', 224*224*3))  # Input size
-        
-        # Write some dummy weights (not real model weights)
-        dummy_weights = np.random.randn(1000, 224*224*3).astype(np.float32)
-        f.write(dummy_weights.tobytes())
-    
-    print(f"Created placeholder model with size: {os.path.getsize(output_path)} bytes")
+    print(f"Creating test GGML model at: {output_path}")
+
+    rng = np.random.default_rng(0)
+    writer = GGUFGraphWriter([3, 224, 224])
+    x = writer.conv2d("input", rng.standard_normal((8, 3, 3, 3)) * 0.1, rng.standard_normal(8) * 0.1, stride=2, pad=1)
+    x = writer.add_node("relu", [x])
+    x = writer.add_node("maxpool2d", [x], {"kernel": 2, "stride": 2, "pad": 0})
+    x = writer.add_node("global_avgpool", [x])
+    x = writer.add_node("flatten", [x])
+    x = writer.linear(x, rng.standard_normal((1000, 8)) * 0.1, np.zeros(1000))
+    writer.write(output_path, [x], name="test_cnn")
+
+    print(f"Created test model with size: {os.path.getsize(output_path)} bytes")
     return output_path
 
 if __name__ == "__main__":
-    import sys
-    
     if len(sys.argv) > 1:
         output_path = sys.argv[1]
     else:
-        output_path = "/tmp/test_ggml_model.bin"
-    
+        output_path = "/tmp/test_ggml_model.gguf"
+
     try:
         model_path = create_simple_ggml_model(output_path)
-        
+
         # Write the model path to a file for the test
         with open("model_path.txt", "w") as f:
             f.write(model_path + "\n")
-        
+
         print(f"Model path written to model_path.txt: {model_path}")
-        print("Note: This is a placeholder model for testing infrastructure only.")
-        print("For real testing, you would need to convert an actual model to GGML format.")
-        
+
     except Exception as e:
         print(f"Error creating test model: {e}")
         sys.exit(1)
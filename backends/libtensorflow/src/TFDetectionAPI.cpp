@@ -1,118 +1,401 @@
 #include "TFDetectionAPI.hpp"
+#include <tensorflow/cc/tools/freeze_saved_model.h>
+#include <tensorflow/core/framework/node_def_util.h>
+#include <tensorflow/core/platform/env.h>
+#include <tensorflow/core/protobuf/meta_graph.pb.h>
+#include <tensorflow/core/util/memmapped_file_system_writer.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <unordered_set>
 
 enum class CHW {C=1, H, W};
 
+namespace {
+
+// Package entry holding the SignatureDef the graph was frozen for, keyed by its name in a MetaGraphDef
+const std::string kMemmappedSignatureDefs = std::string(tensorflow::MemmappedFileSystem::kMemmappedPackagePrefix) + "signature_defs";
+
+} // namespace
+
 TFDetectionAPI::TFDetectionAPI(const std::string& model_path, 
     bool use_gpu, 
     size_t batch_size, 
-    const std::vector<std::vector<int64_t>>& input_sizes) : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
+    const std::vector<std::vector<int64_t>>& input_sizes,
+    const TFOptions& options) : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
 {
     tensorflow::SessionOptions session_options;
-    tensorflow::RunOptions run_options;
-    tensorflow::Status status = LoadSavedModel(session_options, run_options, 
-        model_path, {"serve"}, &bundle_);
-
-    if (!status.ok()) {
-        LOG(ERROR) << "Error loading the model: " << status.ToString();
-        throw std::runtime_error("Failed to load TensorFlow model: " + status.ToString());
+    session_options.config.set_intra_op_parallelism_threads(options.intra_op_threads);
+    session_options.config.set_inter_op_parallelism_threads(options.inter_op_threads);
+    if (options.xla_jit) {
+        auto* optimizer_options = session_options.config.mutable_graph_options()->mutable_optimizer_options();
+        optimizer_options->set_global_jit_level(tensorflow::OptimizerOptions::ON_1);
+        optimizer_options->set_cpu_global_jit(true);
     }
 
-    // session_ is not needed since we can use bundle_.GetSession() directly
+    tensorflow::SignatureDef signature_def;
+    if (std::filesystem::is_regular_file(model_path)) {
+        // A single file is a memmapped package written by convert_to_memmapped()
+        load_memmapped(model_path, options.signature, session_options, signature_def);
+    } else {
+        tensorflow::RunOptions run_options;
+        tensorflow::Status status = LoadSavedModel(session_options, run_options, 
+            model_path, {"serve"}, &bundle_);
 
-    // Get the SignatureDef
-    const auto& signature_def = bundle_.GetSignatures().at("serving_default");
+        if (!status.ok()) {
+            LOG(ERROR) << "Error loading the model: " << status.ToString();
+            throw std::runtime_error("Failed to load TensorFlow model: " + status.ToString());
+        }
+        session_ = bundle_.GetSession();
 
-    // Get input tensor info
+        // Get the SignatureDef
+        const auto& signatures = bundle_.GetSignatures();
+        const auto signature_it = signatures.find(options.signature);
+        if (signature_it == signatures.end()) {
+            std::string available;
+            for (const auto& signature : signatures) {
+                available += (available.empty() ? "" : ", ") + signature.first;
+            }
+            throw ModelLoadException("Signature '" + options.signature + "' not found, available: " + available);
+        }
+        signature_def = signature_it->second;
+    }
+
+    // Get input tensor infos, image inputs first and otherwise ordered by key so the feed order is stable
     const auto& inputs = signature_def.inputs();
     if (inputs.empty()) {
         LOG(ERROR) << "No inputs found in the model";
         throw std::runtime_error("No inputs found in TensorFlow model");
     }
-    input_info_ = inputs.begin()->second;
-    input_name_ = input_info_.name();
-    LOG(INFO) << "Tensor Input name: " << input_name_;
+    for (const auto& input : inputs) {
+        SignatureInput signature_input;
+        signature_input.key = input.first;
+        signature_input.info = input.second;
+        signature_input.is_image = input.second.has_tensor_shape() && input.second.tensor_shape().dim_size() == 4;
+        inputs_.push_back(std::move(signature_input));
+    }
+    std::sort(inputs_.begin(), inputs_.end(), [](const SignatureInput& a, const SignatureInput& b) {
+        return a.is_image != b.is_image ? a.is_image : a.key < b.key;
+    });
 
-    // Extract dimensions and convert from NHWC to NCHW layout (excluding batch)
-    std::vector<int64_t> input_shape;
-    const auto& dim = input_info_.tensor_shape().dim();
+    for (const auto& input : inputs_) {
+        LOG(INFO) << "Tensor Input name: " << input.info.name() << " (key " << input.key
+                  << ", dtype " << tensorflow::DataTypeString(input.info.dtype()) << ")";
 
-    // NHWC: [Batch, Height, Width, Channels]
-    // NCHW: [Batch, Channels, Height, Width]
-    // Extract Channels (dim 3), Height (dim 1), Width (dim 2)
-    input_shape.push_back(dim[3].size());  // Channels
-    input_shape.push_back(dim[1].size());  // Height
-    input_shape.push_back(dim[2].size());  // Width
+        std::vector<int64_t> input_shape;
+        const auto& dim = input.info.tensor_shape().dim();
+        if (input.is_image) {
+            // NHWC: [Batch, Height, Width, Channels], reported as CHW excluding batch
+            input_shape.push_back(dim[3].size());  // Channels
+            input_shape.push_back(dim[1].size());  // Height
+            input_shape.push_back(dim[2].size());  // Width
+            model_info_.addInput(input.info.name(), input_shape, batch_size, TensorLayout::NHWC);
+        } else {
+            for (int i = 1; i < dim.size(); ++i) {
+                input_shape.push_back(dim[i].size());
+            }
+            model_info_.addInput(input.info.name(), input_shape, batch_size);
+        }
+    }
 
-    LOG(INFO) << "Reshaped Tensor (NCHW order, excluding batch): "
-              << "[" << input_shape[0] << ", " << input_shape[1] << ", " << input_shape[2] << "]";
-    
-    model_info_.addInput(input_name_, input_shape, batch_size);
+    // Get output tensor names and shapes (excluding batch size), only the requested ones if any
+    // (protobuf map iteration order is unspecified, so all outputs are fetched in key order)
+    std::vector<std::string> output_keys = options.outputs;
+    if (output_keys.empty()) {
+        for (const auto& output : signature_def.outputs()) {
+            output_keys.push_back(output.first);
+        }
+        std::sort(output_keys.begin(), output_keys.end());
+    }
+    std::vector<const tensorflow::TensorInfo*> selected_outputs;
+    for (const auto& key : output_keys) {
+        const auto output_it = signature_def.outputs().find(key);
+        if (output_it == signature_def.outputs().end()) {
+            throw ModelLoadException("Output '" + key + "' not found in signature '" + options.signature + "'");
+        }
+        selected_outputs.push_back(&output_it->second);
+    }
 
-    // Get output tensor names and shapes (excluding batch size)
     LOG(INFO) << "Tensor output names and shapes:";
-    for (const auto& output : signature_def.outputs()) {
-        if (!output.second.has_name()) {
+    for (const auto* output : selected_outputs) {
+        if (!output->has_name()) {
             LOG(WARNING) << "Output tensor missing name, skipping";
             continue;
         }
         
-        std::string output_name = output.second.name();
+        std::string output_name = output->name();
         output_names_.push_back(output_name);
         LOG(INFO) << output_name;
 
         std::vector<int64_t> output_shape;
-        if (output.second.has_tensor_shape()) {
-            const auto& tensor_shape = output.second.tensor_shape();
+        if (output->has_tensor_shape()) {
+            const auto& tensor_shape = output->tensor_shape();
             for (int i = 1; i < tensor_shape.dim_size(); ++i) { // Start from index 1 to skip batch size
-                if (i < tensor_shape.dim_size()) {
-                    output_shape.push_back(tensor_shape.dim(i).size());
-                }
+                output_shape.push_back(tensor_shape.dim(i).size());
             }
         }
         model_info_.addOutput(output_name, output_shape, batch_size);
     }
+
+    // Resolve feeds and fetches once instead of looking names up on every Run
+    tensorflow::CallableOptions callable_options;
+    for (const auto& input : inputs_) {
+        callable_options.add_feed(input.info.name());
+    }
+    for (const auto& output_name : output_names_) {
+        callable_options.add_fetch(output_name);
+    }
+    tensorflow::Status status = session_->MakeCallable(callable_options, &callable_);
+    if (!status.ok()) {
+        LOG(ERROR) << "Error creating the session callable: " << status.ToString();
+        throw std::runtime_error("Failed to create TensorFlow callable: " + status.ToString());
+    }
+    callable_created_ = true;
 }
 
-std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> TFDetectionAPI::get_infer_results(const cv::Mat& input_blob) 
+void TFDetectionAPI::load_memmapped(const std::string& model_path, const std::string& signature,
+    tensorflow::SessionOptions session_options, tensorflow::SignatureDef& signature_def)
 {
-    // The input_blob from cv::dnn::blobFromImage is in NCHW format (batch, channels, height, width)
-    // TensorFlow expects NHWC format (batch, height, width, channels)
-    // So we need to transpose from NCHW to NHWC
-    
-    int batch_size = input_blob.size[0];
-    int channels = input_blob.size[1];
-    int height = input_blob.size[2];
-    int width = input_blob.size[3];
-    
-    // Create tensor with proper shape for NHWC format
-    tensorflow::Tensor input_tensor(input_info_.dtype(), 
-        tensorflow::TensorShape({batch_size, height, width, channels}));
-  
-    // Copy data with NCHW to NHWC transpose
-    auto tensor_data = input_tensor.flat<float>().data();
-    const float* blob_data = input_blob.ptr<float>();
-    
-    // Transpose from NCHW to NHWC
-    for (int b = 0; b < batch_size; ++b) {
-        for (int h = 0; h < height; ++h) {
-            for (int w = 0; w < width; ++w) {
-                for (int c = 0; c < channels; ++c) {
-                    int nchw_idx = b * channels * height * width + c * height * width + h * width + w;
-                    int nhwc_idx = b * height * width * channels + h * width * channels + w * channels + c;
-                    tensor_data[nhwc_idx] = blob_data[nchw_idx];
-                }
-            }
+    memmapped_env_ = std::make_unique<tensorflow::MemmappedEnv>(tensorflow::Env::Default());
+    tensorflow::Status status = memmapped_env_->InitializeFromFile(model_path);
+
+    tensorflow::GraphDef graph_def;
+    tensorflow::MetaGraphDef signatures;
+    if (status.ok()) {
+        status = tensorflow::ReadBinaryProto(memmapped_env_.get(),
+            tensorflow::MemmappedFileSystem::kMemmappedPackageDefaultGraphDef, &graph_def);
+    }
+    if (status.ok()) {
+        status = tensorflow::ReadBinaryProto(memmapped_env_.get(), kMemmappedSignatureDefs, &signatures);
+    }
+    if (!status.ok()) {
+        throw ModelLoadException("Failed to read memmapped package " + model_path + ": " + status.ToString());
+    }
+
+    // The graph is frozen for one signature, another one cannot be served from it
+    const auto signature_it = signatures.signature_def().find(signature);
+    if (signature_it == signatures.signature_def().end()) {
+        std::string available;
+        for (const auto& entry : signatures.signature_def()) {
+            available += (available.empty() ? "" : ", ") + entry.first;
         }
+        throw ModelLoadException("Signature '" + signature + "' not found in memmapped package " + model_path +
+            ", it was converted for: " + available);
     }
+    signature_def = signature_it->second;
+
+    // ImmutableConst ops read the weights from the mapped file; constant folding would copy them back to the heap
+    session_options.env = memmapped_env_.get();
+    auto* graph_options = session_options.config.mutable_graph_options();
+    graph_options->mutable_optimizer_options()->set_opt_level(tensorflow::OptimizerOptions::L0);
+    graph_options->mutable_rewrite_options()->set_constant_folding(tensorflow::RewriterConfig::OFF);
+
+    tensorflow::Session* session = nullptr;
+    status = tensorflow::NewSession(session_options, &session);
+    owned_session_.reset(session);
+    if (status.ok()) {
+        status = owned_session_->Create(graph_def);
+    }
+    if (!status.ok()) {
+        throw ModelLoadException("Failed to create session for memmapped graph: " + status.ToString());
+    }
+    session_ = owned_session_.get();
+    LOG(INFO) << "Loaded memmapped graph " << model_path << " (" << graph_def.node_size() << " nodes)";
+}
 
-    // Prepare inputs for running the session
-    std::vector<std::pair<std::string, tensorflow::Tensor>> inputs_for_session = {
-        {input_name_, input_tensor}
+void TFDetectionAPI::convert_to_memmapped(const std::string& saved_model_dir, const std::string& output_path,
+    const std::string& signature, size_t min_conversion_bytes)
+{
+    tensorflow::SavedModelBundle bundle;
+    tensorflow::Status status = tensorflow::LoadSavedModel(tensorflow::SessionOptions(), tensorflow::RunOptions(),
+        saved_model_dir, {"serve"}, &bundle);
+    if (!status.ok()) {
+        throw ModelLoadException("Failed to load TensorFlow model: " + status.ToString());
+    }
+    const auto signature_it = bundle.GetSignatures().find(signature);
+    if (signature_it == bundle.GetSignatures().end()) {
+        throw ModelLoadException("Signature '" + signature + "' not found in " + saved_model_dir);
+    }
+
+    // Variables become constants in a frozen GraphDef
+    tensorflow::GraphDef graph_def;
+    std::unordered_set<std::string> frozen_inputs;
+    std::unordered_set<std::string> frozen_outputs;
+    status = tensorflow::FreezeSavedModel(bundle, &graph_def, &frozen_inputs, &frozen_outputs);
+    if (!status.ok()) {
+        throw ModelLoadException("Failed to freeze SavedModel: " + status.ToString());
+    }
+
+    tensorflow::MemmappedFileSystemWriter writer;
+    status = writer.InitializeToFile(tensorflow::Env::Default(), output_path);
+
+    // Constants above the threshold move into aligned package regions, replaced by ImmutableConst ops mapping them
+    size_t converted = 0;
+    for (auto& node : *graph_def.mutable_node()) {
+        if (!status.ok()) {
+            break;
+        }
+        if (node.op() != "Const") {
+            continue;
+        }
+        tensorflow::Tensor value;
+        if (!value.FromProto(node.attr().at("value").tensor())) {
+            throw ModelLoadException("Invalid value for constant " + node.name());
+        }
+        if (value.dtype() == tensorflow::DataType::DT_STRING || value.TotalBytes() < min_conversion_bytes) {
+            continue;
+        }
+
+        const std::string region = std::string(tensorflow::MemmappedFileSystem::kMemmappedPackagePrefix)
+            + "const_" + std::to_string(converted++);
+        status = writer.SaveTensor(value, region);
+
+        tensorflow::NodeDef immutable;
+        immutable.set_name(node.name());
+        immutable.set_op("ImmutableConst");
+        immutable.set_device(node.device());
+        for (const auto& input : node.input()) {
+            immutable.add_input(input);
+        }
+        tensorflow::AddNodeAttr("dtype", value.dtype(), &immutable);
+        tensorflow::AddNodeAttr("shape", value.shape(), &immutable);
+        tensorflow::AddNodeAttr("memory_region_name", region, &immutable);
+        node = std::move(immutable);
+    }
+
+    if (status.ok()) {
+        tensorflow::MetaGraphDef signatures;
+        (*signatures.mutable_signature_def())[signature] = signature_it->second;
+        status = writer.SaveProtobuf(signatures, kMemmappedSignatureDefs);
+    }
+    if (status.ok()) {
+        status = writer.SaveProtobuf(graph_def, tensorflow::MemmappedFileSystem::kMemmappedPackageDefaultGraphDef);
+    }
+    if (status.ok()) {
+        status = writer.FlushAndClose();
+    }
+    if (!status.ok()) {
+        throw ModelLoadException("Failed to write memmapped package " + output_path + ": " + status.ToString());
+    }
+    LOG(INFO) << "Wrote " << output_path << " with " << converted << " memmapped constants";
+}
+
+std::vector<std::string> TFDetectionAPI::get_input_keys() const
+{
+    std::vector<std::string> keys;
+    for (const auto& input : inputs_) {
+        keys.push_back(input.key);
+    }
+    return keys;
+}
+
+void TFDetectionAPI::fill_input_tensor(SignatureInput& input, const cv::Mat& blob)
+{
+    if (!blob.isContinuous()) {
+        throw InferenceExecutionException("Input '" + input.key + "' must be a continuous cv::Mat");
+    }
+
+    tensorflow::TensorShape shape;
+    bool is_nhwc = true;
+    if (input.is_image) {
+        // TensorFlow consumes NHWC. Blobs built with blob_from_image() (or a single HWC image)
+        // already are NHWC and are copied as is; NCHW blobs from cv::dnn::blobFromImage are transposed.
+        const int64_t model_channels = input.info.tensor_shape().dim(3).size();
+        const bool is_image = blob.dims == 2;
+        if (!is_image && blob.dims != 4) {
+            throw InferenceExecutionException("Image input '" + input.key + "' expects an HWC image or a 4D blob");
+        }
+        is_nhwc = is_image || (blob.size[3] == model_channels && blob.size[1] != model_channels);
+
+        const int batch_size = is_image ? 1 : blob.size[0];
+        const int channels = is_image ? blob.channels() : (is_nhwc ? blob.size[3] : blob.size[1]);
+        const int height = is_image ? blob.rows : (is_nhwc ? blob.size[1] : blob.size[2]);
+        const int width = is_image ? blob.cols : (is_nhwc ? blob.size[2] : blob.size[3]);
+        shape = tensorflow::TensorShape({batch_size, height, width, channels});
+    } else {
+        // Generic inputs take the cv::Mat shape, with leading unit dimensions dropped down to the signature rank
+        std::vector<int64_t> dims(blob.size.p, blob.size.p + blob.dims);
+        if (blob.channels() > 1) {
+            dims.push_back(blob.channels());
+        }
+        const auto& tensor_shape = input.info.tensor_shape();
+        const int rank = tensor_shape.unknown_rank() ? -1 : tensor_shape.dim_size();
+        while (rank >= 0 && static_cast<int>(dims.size()) > rank && dims.front() == 1) {
+            dims.erase(dims.begin());
+        }
+        for (const auto dim : dims) {
+            shape.AddDim(dim);
+        }
+    }
+
+    // Reuse the input tensor unless the shape changed or a previous run still holds its buffer
+    if (!input.tensor.IsInitialized() || input.tensor.shape() != shape || !input.tensor.RefCountIsOne()) {
+        input.tensor = tensorflow::Tensor(input.info.dtype(), shape);
+    }
+
+    const auto expect_depth = [&](int depth, const char* type) {
+        if (blob.depth() != depth) {
+            throw InferenceExecutionException("Input '" + input.key + "' expects a " + type + " cv::Mat");
+        }
+        if (!is_nhwc) {
+            throw InferenceExecutionException("Input '" + input.key + "' only accepts NHWC data, NCHW blobs are float only");
+        }
     };
 
+    switch (input.info.dtype()) {
+        case tensorflow::DataType::DT_FLOAT: {
+            if (blob.depth() != CV_32F) {
+                throw InferenceExecutionException("Input '" + input.key + "' expects a CV_32F cv::Mat");
+            }
+            const auto& dims = input.tensor.shape();
+            if (is_nhwc) {
+                std::copy(blob.ptr<float>(), blob.ptr<float>() + input.tensor.NumElements(), input.tensor.flat<float>().data());
+            } else {
+                convert_layout(blob.ptr<float>(), input.tensor.flat<float>().data(), dims.dim_size(0), dims.dim_size(3),
+                    dims.dim_size(1), dims.dim_size(2), TensorLayout::NCHW, TensorLayout::NHWC);
+            }
+            break;
+        }
+        case tensorflow::DataType::DT_UINT8:
+            expect_depth(CV_8U, "CV_8U");
+            std::memcpy(input.tensor.flat<uint8_t>().data(), blob.data, input.tensor.NumElements());
+            break;
+        case tensorflow::DataType::DT_INT32:
+            expect_depth(CV_32S, "CV_32S");
+            std::copy(blob.ptr<int32_t>(), blob.ptr<int32_t>() + input.tensor.NumElements(), input.tensor.flat<int32_t>().data());
+            break;
+        case tensorflow::DataType::DT_INT64:
+            // OpenCV has no 64-bit integer Mat, values are widened from CV_32S
+            expect_depth(CV_32S, "CV_32S");
+            std::copy(blob.ptr<int32_t>(), blob.ptr<int32_t>() + input.tensor.NumElements(), input.tensor.flat<int64_t>().data());
+            break;
+        default:
+            throw InferenceExecutionException("Unsupported dtype " + tensorflow::DataTypeString(input.info.dtype())
+                + " for input '" + input.key + "'");
+    }
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> TFDetectionAPI::get_infer_results(const cv::Mat& input_blob) 
+{
+    return get_infer_results(std::map<std::string, cv::Mat>{{inputs_[0].key, input_blob}});
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> TFDetectionAPI::get_infer_results(const std::map<std::string, cv::Mat>& inputs)
+{
+    std::vector<tensorflow::Tensor> feeds;
+    feeds.reserve(inputs_.size());
+    for (auto& input : inputs_) {
+        const auto blob_it = inputs.find(input.key);
+        if (blob_it == inputs.end()) {
+            throw InferenceExecutionException("Missing value for signature input '" + input.key + "'");
+        }
+        fill_input_tensor(input, blob_it->second);
+        feeds.push_back(input.tensor);
+    }
+
     // Run the inference
     std::vector<tensorflow::Tensor> outputs;
-    auto status = bundle_.GetSession()->Run(inputs_for_session, output_names_, {}, &outputs);
+    auto status = session_->RunCallable(callable_, feeds, &outputs, nullptr);
     if (!status.ok()) {
         LOG(ERROR) << "Error running session: " << status.ToString();
         throw std::runtime_error("Failed to run TensorFlow session: " + status.ToString());
@@ -139,6 +422,10 @@ std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int6
             for (int i = 0; i < tensor.NumElements(); ++i) {
                 outputData.emplace_back(tensor.flat<int32_t>()(i));
             }
+        } else if (tensor.dtype() == tensorflow::DataType::DT_UINT8) {
+            for (int i = 0; i < tensor.NumElements(); ++i) {
+                outputData.emplace_back(static_cast<int32_t>(tensor.flat<uint8_t>()(i)));
+            }
         } else if (tensor.dtype() == tensorflow::DataType::DT_INT64) {
             for (int i = 0; i < tensor.NumElements(); ++i) {
                 outputData.emplace_back(tensor.flat<int64_t>()(i));
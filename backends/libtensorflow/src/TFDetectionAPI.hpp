@@ -3,7 +3,20 @@
 #include <tensorflow/cc/saved_model/loader.h>
 #include <tensorflow/core/framework/tensor.h>
 #include <tensorflow/core/public/session.h>
+#include <tensorflow/core/util/memmapped_file_system.h>
 #include "opencv2/opencv.hpp"
+#include <map>
+
+struct TFOptions {
+    // Session thread pools, 0 lets TensorFlow pick one thread per core
+    int intra_op_threads = 0;
+    int inter_op_threads = 0;
+    // XLA JIT compilation of clusters on CPU (global_jit_level ON_1 with cpu_global_jit)
+    bool xla_jit = false;
+    // SignatureDef to run, and the signature output keys to fetch (empty fetches every output)
+    std::string signature = "serving_default";
+    std::vector<std::string> outputs;
+};
 
 class TFDetectionAPI : public InferenceInterface{
 
@@ -11,21 +24,59 @@ public:
     TFDetectionAPI(const std::string& model_path, 
         bool use_gpu = false, 
         size_t batch_size = 1, 
-        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>());
+        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>(),
+        const TFOptions& options = TFOptions());
 
     ~TFDetectionAPI() {
-        // The session is owned by bundle_, so we don't need to close it manually
-        // bundle_ will handle the session cleanup in its destructor
+        // The session is owned by bundle_ (or owned_session_ for memmapped graphs),
+        // both clean up in their destructors, only the callable needs releasing here
+        if (callable_created_) {
+            session_->ReleaseCallable(callable_);
+        }
     }
 
+    // Feeds the first signature input (the image input when there is one)
     std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
 
+    // Feeds every signature input by key, each in its native dtype: CV_8U for uint8, CV_32F for float
+    // and CV_32S for int32/int64 inputs. Image inputs take NHWC blobs or HWC images; uint8 image inputs
+    // take the CV_8UC3 image as is, without any float conversion.
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const std::map<std::string, cv::Mat>& inputs);
+
+    // Signature input keys in feed order, image inputs first
+    std::vector<std::string> get_input_keys() const;
+
+    // Freezes a SavedModel signature into a memmapped package: weights become page-aligned regions of
+    // a single file that TFDetectionAPI maps instead of reading, so processes share them through the
+    // page cache. Constants smaller than min_conversion_bytes stay inline in the graph. The package
+    // only serves the signature it was converted for; loading it with another TFOptions::signature throws.
+    static void convert_to_memmapped(const std::string& saved_model_dir, const std::string& output_path,
+        const std::string& signature = "serving_default", size_t min_conversion_bytes = 1024);
+
 private:
 
+    struct SignatureInput {
+        std::string key;
+        tensorflow::TensorInfo info;
+        bool is_image = false;      // Rank 4 NHWC input
+        tensorflow::Tensor tensor;  // Reused across calls
+    };
+
+    void fill_input_tensor(SignatureInput& input, const cv::Mat& blob);
+    void load_memmapped(const std::string& model_path, const std::string& signature,
+        tensorflow::SessionOptions session_options, tensorflow::SignatureDef& signature_def);
+
     std::string model_path_;
     tensorflow::SavedModelBundle bundle_;   
-    tensorflow::TensorInfo input_info_;
-    std::string input_name_;
+    // Memmapped graphs: the env must outlive the session reading from it
+    std::unique_ptr<tensorflow::MemmappedEnv> memmapped_env_;
+    std::unique_ptr<tensorflow::Session> owned_session_;
+    tensorflow::Session* session_ = nullptr;
+    std::vector<SignatureInput> inputs_;
     std::vector<std::string> output_names_;
+
+    // Feeds/fetches resolved once into a callable, input tensors are reused across calls
+    tensorflow::Session::CallableHandle callable_;
+    bool callable_created_ = false;
     
 };
\ No newline at end of file
@@ -213,6 +213,115 @@ TEST_F(TensorFlowInferTest, ModelInfoTest) {
     }
 }
 
+// Repeated runs reuse the callable and input tensor - only runs with real model
+TEST_F(TensorFlowInferTest, CallableRepeatedRuns) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping callable test - no real model available";
+    }
+
+    TFOptions options;
+    options.intra_op_threads = 2;
+    options.inter_op_threads = 1;
+    auto threaded_infer = std::make_unique<TFDetectionAPI>(model_path, false, 1, std::vector<std::vector<int64_t>>(), options);
+
+    cv::Mat zeros = cv::Mat::zeros(224, 224, CV_32FC3);
+    cv::Mat ones = cv::Mat::ones(224, 224, CV_32FC3);
+    cv::Mat zeros_blob, ones_blob;
+    cv::dnn::blobFromImage(zeros, zeros_blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+    cv::dnn::blobFromImage(ones, ones_blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [first_outputs, first_shapes] = threaded_infer->get_infer_results(zeros_blob);
+    auto [other_outputs, other_shapes] = threaded_infer->get_infer_results(ones_blob);
+    auto [again_outputs, again_shapes] = threaded_infer->get_infer_results(zeros_blob);
+
+    // Earlier results are not overwritten by later runs and identical inputs give identical outputs
+    ASSERT_EQ(first_shapes, again_shapes);
+    ASSERT_EQ(first_outputs[0].size(), again_outputs[0].size());
+    for (size_t i = 0; i < first_outputs[0].size(); ++i) {
+        ASSERT_EQ(first_outputs[0][i], again_outputs[0][i]);
+    }
+}
+
+// NHWC blobs skip the transpose and give the same results - only runs with real model
+TEST_F(TensorFlowInferTest, NativeLayoutInput) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping native layout test - no real model available";
+    }
+
+    ASSERT_EQ(real_infer->get_model_info().getInputs()[0].layout, TensorLayout::NHWC);
+
+    cv::Mat image(224, 224, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat nchw_blob = cv::dnn::blobFromImage(image, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+    cv::Mat nhwc_blob = real_infer->blob_from_image(image, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true);
+
+    auto [nchw_outputs, nchw_shapes] = real_infer->get_infer_results(nchw_blob);
+    auto [nhwc_outputs, nhwc_shapes] = real_infer->get_infer_results(nhwc_blob);
+    ASSERT_EQ(nchw_shapes, nhwc_shapes);
+    for (size_t i = 0; i < nchw_outputs[0].size(); ++i) {
+        ASSERT_NEAR(std::get<float>(nchw_outputs[0][i]), std::get<float>(nhwc_outputs[0][i]), 1e-4f);
+    }
+}
+
+TEST_F(TensorFlowInferTest, SignatureSelection) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping signature test - no real model available";
+    }
+
+    TFOptions missing_signature;
+    missing_signature.signature = "no_such_signature";
+    EXPECT_THROW(TFDetectionAPI(model_path, false, 1, std::vector<std::vector<int64_t>>(), missing_signature), ModelLoadException);
+
+    TFOptions missing_output;
+    missing_output.outputs = {"no_such_output"};
+    EXPECT_THROW(TFDetectionAPI(model_path, false, 1, std::vector<std::vector<int64_t>>(), missing_output), ModelLoadException);
+
+    // Feeding the inputs by key matches the single blob path
+    const auto keys = real_infer->get_input_keys();
+    ASSERT_FALSE(keys.empty());
+    cv::Mat image(224, 224, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat blob = real_infer->blob_from_image(image, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true);
+
+    auto [outputs, shapes] = real_infer->get_infer_results(blob);
+    auto [named_outputs, named_shapes] = real_infer->get_infer_results(std::map<std::string, cv::Mat>{{keys[0], blob}});
+    ASSERT_EQ(shapes, named_shapes);
+    ASSERT_EQ(outputs[0].size(), named_outputs[0].size());
+    EXPECT_THROW(real_infer->get_infer_results(std::map<std::string, cv::Mat>{}), InferenceExecutionException);
+}
+
+TEST_F(TensorFlowInferTest, MemmappedGraph) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping memmapped test - no real model available";
+    }
+
+    const auto package = fs::temp_directory_path() / "tf_memmapped_test.mmpb";
+    TFDetectionAPI::convert_to_memmapped(model_path, package.string());
+    ASSERT_TRUE(fs::is_regular_file(package));
+
+    auto memmapped_infer = std::make_unique<TFDetectionAPI>(package.string(), false);
+    ASSERT_EQ(memmapped_infer->get_input_keys(), real_infer->get_input_keys());
+
+    cv::Mat image(224, 224, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat blob = real_infer->blob_from_image(image, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true);
+
+    auto [outputs, shapes] = real_infer->get_infer_results(blob);
+    auto [memmapped_outputs, memmapped_shapes] = memmapped_infer->get_infer_results(blob);
+    ASSERT_EQ(shapes, memmapped_shapes);
+    for (size_t i = 0; i < outputs[0].size(); ++i) {
+        ASSERT_NEAR(std::get<float>(outputs[0][i]), std::get<float>(memmapped_outputs[0][i]), 1e-4f);
+    }
+
+    // The package is frozen for serving_default only
+    TFOptions other_signature;
+    other_signature.signature = "no_such_signature";
+    EXPECT_THROW(TFDetectionAPI(package.string(), false, 1, {}, other_signature), ModelLoadException);
+
+    memmapped_infer.reset();
+    fs::remove(package);
+}
+
 // Signal handler for crashes
 void signal_handler(int signal) {
     std::cerr << "Received signal " << signal << " - TensorFlow backend may have crashed" << std::endl;
@@ -0,0 +1,24 @@
+// Converts a SavedModel into the memmapped package format loaded by TFDetectionAPI.
+// Usage: tf_convert_memmapped <saved_model_dir> <output_file> [signature] [min_conversion_bytes]
+#include "TFDetectionAPI.hpp"
+#include <glog/logging.h>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    google::InitGoogleLogging(argv[0]);
+    if (argc < 3 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " <saved_model_dir> <output_file> [signature] [min_conversion_bytes]" << std::endl;
+        return 1;
+    }
+
+    const std::string signature = argc > 3 ? argv[3] : "serving_default";
+    const size_t min_conversion_bytes = argc > 4 ? std::stoul(argv[4]) : 1024;
+    try {
+        TFDetectionAPI::convert_to_memmapped(argv[1], argv[2], signature, min_conversion_bytes);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,6 +1,50 @@
 #include "LibtorchInfer.hpp"
+#include <torch/csrc/jit/codegen/onednn/interface.h>
+#include <ATen/autocast_mode.h>
 #include <sstream>
 
+namespace {
+// Scoped CPU autocast to bfloat16, restoring the previous thread-local autocast state on exit
+class CpuAutocastGuard
+{
+public:
+    explicit CpuAutocastGuard(bool enabled) : enabled_(enabled)
+    {
+        if (!enabled_)
+        {
+            return;
+        }
+        prev_enabled_ = at::autocast::is_cpu_enabled();
+        prev_dtype_ = at::autocast::get_autocast_cpu_dtype();
+        at::autocast::set_cpu_enabled(true);
+        at::autocast::set_autocast_cpu_dtype(at::kBFloat16);
+        at::autocast::increment_nesting();
+    }
+
+    ~CpuAutocastGuard()
+    {
+        if (!enabled_)
+        {
+            return;
+        }
+        if (at::autocast::decrement_nesting() == 0)
+        {
+            at::autocast::clear_cache();
+        }
+        at::autocast::set_cpu_enabled(prev_enabled_);
+        at::autocast::set_autocast_cpu_dtype(prev_dtype_);
+    }
+
+    CpuAutocastGuard(const CpuAutocastGuard&) = delete;
+    CpuAutocastGuard& operator=(const CpuAutocastGuard&) = delete;
+
+private:
+    bool enabled_;
+    bool prev_enabled_ = false;
+    at::ScalarType prev_dtype_ = at::kBFloat16;
+};
+}
+
 std::string LibtorchInfer::print_shape(const std::vector<int64_t>& shape)
 {
     std::stringstream ss;
@@ -17,9 +61,12 @@ std::string LibtorchInfer::print_shape(const std::vector<int64_t>& shape)
     return ss.str();
 }
 
-LibtorchInfer::LibtorchInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes) 
+LibtorchInfer::LibtorchInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes, const LibtorchOptions& options) 
     : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
+    , options_(options)
 {
+    configure_threads();
+
     if (use_gpu && torch::cuda::is_available())
     {
         device_ = torch::kCUDA;
@@ -41,6 +88,22 @@ LibtorchInfer::LibtorchInfer(const std::string& model_path, bool use_gpu, size_t
         std::exit(1);
     }
 
+    module_.eval();
+    if (options_.bf16_autocast && device_ != torch::kCPU)
+    {
+        LOG(WARNING) << "bf16 autocast is a CPU execution mode, ignoring it on GPU";
+        options_.bf16_autocast = false;
+    }
+    // Weights must be in their final layout before freezing turns them into constants
+    if (options_.channels_last)
+    {
+        convert_to_channels_last();
+    }
+    if (options_.optimize)
+    {
+        optimize_module();
+    }
+
     // Process inputs
     LOG(INFO) << "Input Node Name/Shape:";
     auto method = module_.get_method("forward");
@@ -48,6 +111,7 @@ LibtorchInfer::LibtorchInfer(const std::string& model_path, bool use_gpu, size_t
     auto inputs = graph->inputs();
     
     // Skip the first input as it's usually the self/module input
+    num_forward_inputs_ = inputs.size() - 1;
     for (size_t i = 1; i < inputs.size(); ++i)
     {
         auto input = inputs[i];
@@ -72,7 +136,13 @@ LibtorchInfer::LibtorchInfer(const std::string& model_path, bool use_gpu, size_t
         std::vector<int64_t> final_shape = *shapes;
 
         LOG(INFO) << "\t" << name << " : " << print_shape(final_shape);
-        model_info_.addInput(name, final_shape, batch_size);
+        if (i == 1 && final_shape.size() >= 3)
+        {
+            image_channels_ = final_shape[final_shape.size() - 3];
+        }
+        // channels_last weights run on NHWC memory, so image blobs are asked for in that order
+        const bool nhwc = i == 1 && options_.channels_last && final_shape.size() >= 3;
+        model_info_.addInput(name, final_shape, batch_size, nhwc ? TensorLayout::NHWC : TensorLayout::NCHW);
 
         std::string input_type_str = type->scalarType().has_value() ? toString(type->scalarType().value()) : "Unknown";
         LOG(INFO) << "\tData Type: " << input_type_str;
@@ -113,81 +183,245 @@ LibtorchInfer::LibtorchInfer(const std::string& model_path, bool use_gpu, size_t
     }
 }
 
+void LibtorchInfer::configure_threads()
+{
+    if (options_.intra_op_threads > 0)
+    {
+        at::set_num_threads(options_.intra_op_threads);
+    }
+    if (options_.inter_op_threads > 0)
+    {
+        // The inter-op pool can only be sized before its first use in the process
+        try
+        {
+            at::set_num_interop_threads(options_.inter_op_threads);
+        }
+        catch (const c10::Error& e)
+        {
+            LOG(WARNING) << "Inter-op threads already initialized, keeping " << at::get_num_interop_threads();
+        }
+    }
+    LOG(INFO) << "Intra-op threads: " << at::get_num_threads() << ", inter-op threads: " << at::get_num_interop_threads();
+}
+
+void LibtorchInfer::convert_to_channels_last()
+{
+    torch::NoGradGuard no_grad;
+    size_t converted = 0;
+    for (auto parameter : module_.parameters())
+    {
+        if (parameter.dim() == 4)
+        {
+            parameter.set_data(parameter.contiguous(at::MemoryFormat::ChannelsLast));
+            ++converted;
+        }
+    }
+    LOG(INFO) << "Converted " << converted << " weight tensors to channels_last";
+}
+
+void LibtorchInfer::optimize_module()
+{
+    if (options_.onednn_fusion && device_ == torch::kCPU)
+    {
+        torch::jit::RegisterLlgaFuseGraph::setEnabled(true);
+        LOG(INFO) << "oneDNN Graph fusion enabled";
+    }
+
+    try
+    {
+        // optimize_for_inference freezes the module first when it is not frozen yet
+        module_ = torch::jit::optimize_for_inference(module_);
+        LOG(INFO) << "Module frozen and optimized for inference";
+    }
+    catch (const c10::Error& e)
+    {
+        LOG(WARNING) << "optimize_for_inference failed, running the module as loaded: " << e.what();
+    }
+}
+
 std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> 
 LibtorchInfer::get_infer_results(const cv::Mat& preprocessed_img)
 {
-    // Convert the input image to a blob swapping channels order from hwc to chw    
+    return get_infer_results(preprocessed_img, {});
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> 
+LibtorchInfer::get_infer_results(const cv::Mat& preprocessed_img, const std::vector<torch::Tensor>& auxiliary_inputs)
+{
+    // No autograd bookkeeping or version counter updates on the inference path
+    c10::InferenceMode inference_guard;
+
+    // A 4D blob is used as is, keeping its batch dimension;
+    // otherwise convert the input image to a blob in the declared layout
     cv::Mat blob;
-    cv::dnn::blobFromImage(preprocessed_img, blob, 1.0, cv::Size(), cv::Scalar(), false, false);
-    // Convert the input tensor to a Torch tensor
-    torch::Tensor input = torch::from_blob(blob.data, 
-        { 1, blob.size[1], blob.size[2], blob.size[3] }, 
-        torch::kFloat32);
-    input = input.to(device_);
+    bool nhwc = false;
+    if (preprocessed_img.dims == 4 && preprocessed_img.type() == CV_32F)
+    {
+        blob = preprocessed_img.isContinuous() ? preprocessed_img : preprocessed_img.clone();
+        nhwc = options_.channels_last && image_channels_ > 0
+            && blob.size[3] == image_channels_ && blob.size[1] != image_channels_;
+    }
+    else
+    {
+        nhwc = options_.channels_last;
+        blob = ::blob_from_image(preprocessed_img, nhwc ? TensorLayout::NHWC : TensorLayout::NCHW);
+    }
+    // With channels_last an NHWC blob already is the channels_last memory of the NCHW tensor:
+    // wrapping it with permuted strides leaves nothing for forward() to copy
+    torch::Tensor input = nhwc
+        ? torch::from_blob(blob.data, { blob.size[0], blob.size[1], blob.size[2], blob.size[3] }, torch::kFloat32).permute({ 0, 3, 1, 2 })
+        : torch::from_blob(blob.data, { blob.size[0], blob.size[1], blob.size[2], blob.size[3] }, torch::kFloat32);
 
-    // Run inference
-    std::vector<torch::jit::IValue> inputs;
+    // Image first, then the remaining declared inputs in graph order
+    std::vector<torch::Tensor> inputs;
+    inputs.reserve(auxiliary_inputs.size() + 1);
     inputs.push_back(input);
-    auto output = module_.forward(inputs);
+    inputs.insert(inputs.end(), auxiliary_inputs.begin(), auxiliary_inputs.end());
+
+    // Run inference
+    auto named_outputs = forward(inputs);
 
     std::vector<std::vector<TensorElement>> output_vectors;
     std::vector<std::vector<int64_t>> shape_vectors;
+    output_vectors.reserve(named_outputs.size());
+    shape_vectors.reserve(named_outputs.size());
 
-    // Helper function to process a single tensor
-    auto process_tensor = [](const torch::Tensor& tensor) {
+    // Helper function to process a single tensor, converting to the closest TensorElement alternative
+    auto process_tensor = [](torch::Tensor tensor) {
         std::vector<TensorElement> tensor_data;
         tensor_data.reserve(tensor.numel());
-        
-        const auto data_type = tensor.scalar_type();
-        switch (data_type) {
-            case torch::kFloat32: {
-                const float* output_data = tensor.data_ptr<float>();
-                for (size_t i = 0; i < tensor.numel(); ++i) {
-                    tensor_data.emplace_back(output_data[i]);
-                }
-                break;
-            }
-            case torch::kInt64: {
-                const int64_t* output_data = tensor.data_ptr<int64_t>();
-                for (size_t i = 0; i < tensor.numel(); ++i) {
-                    tensor_data.emplace_back(output_data[i]);
-                }
-                break;
-            }
-            default:
-                LOG(ERROR) << "Unsupported tensor type: " << data_type;
-                std::exit(1);
+
+        if (tensor.is_floating_point()) {
+            tensor = tensor.to(torch::kFloat32);
+            const float* output_data = tensor.data_ptr<float>();
+            tensor_data.assign(output_data, output_data + tensor.numel());
+        } else if (tensor.scalar_type() == torch::kInt64) {
+            const int64_t* output_data = tensor.data_ptr<int64_t>();
+            tensor_data.assign(output_data, output_data + tensor.numel());
+        } else if (!tensor.is_complex()) {
+            // Remaining integral types and bool fit in int32
+            tensor = tensor.to(torch::kInt32);
+            const int32_t* output_data = tensor.data_ptr<int32_t>();
+            tensor_data.assign(output_data, output_data + tensor.numel());
+        } else {
+            throw InferenceExecutionException("Unsupported tensor type: " + std::string(c10::toString(tensor.scalar_type())));
         }
         return tensor_data;
     };
 
-    if (output.isTuple()) {
-        // Handle tuple output
-        auto tuple_outputs = output.toTuple()->elements();
-        for (const auto& output_tensor : tuple_outputs) {
-            if (!output_tensor.isTensor()) {
-                continue;
-            }
-            
-            torch::Tensor tensor = output_tensor.toTensor()
-                                              .to(torch::kCPU)
-                                              .contiguous();
-            
-            output_vectors.push_back(process_tensor(tensor));
-            shape_vectors.push_back(tensor.sizes().vec());
-        }
-    } else if (output.isTensor()) {
-        // Handle single tensor output
-        torch::Tensor tensor = output.toTensor()
-                                    .to(torch::kCPU)
-                                    .contiguous();
-        
+    for (const auto& [name, output_tensor] : named_outputs) {
+        torch::Tensor tensor = output_tensor.to(torch::kCPU).contiguous();
         output_vectors.push_back(process_tensor(tensor));
         shape_vectors.push_back(tensor.sizes().vec());
-    } else {
-        LOG(ERROR) << "Unsupported output type: neither tensor nor tuple";
-        std::exit(1);
     }
 
     return std::make_tuple(output_vectors, shape_vectors);
-}
\ No newline at end of file
+}
+
+std::vector<std::pair<std::string, torch::Tensor>> LibtorchInfer::forward(const std::vector<torch::Tensor>& inputs)
+{
+    c10::InferenceMode inference_guard;
+
+    if (inputs.size() != num_forward_inputs_)
+    {
+        throw InferenceExecutionException("LibtorchInfer: model forward takes " + std::to_string(num_forward_inputs_) +
+            " inputs, " + std::to_string(inputs.size()) + " provided");
+    }
+
+    std::vector<torch::jit::IValue> ivalues;
+    ivalues.reserve(inputs.size());
+    for (const auto& input : inputs)
+    {
+        torch::Tensor tensor = input.to(device_);
+        // No-op for inputs already in channels_last memory, e.g. wrapped NHWC blobs
+        if (options_.channels_last && tensor.dim() == 4 && tensor.is_floating_point())
+        {
+            tensor = tensor.contiguous(at::MemoryFormat::ChannelsLast);
+        }
+        ivalues.emplace_back(tensor);
+    }
+
+    torch::jit::IValue output;
+    {
+        CpuAutocastGuard autocast_guard(options_.bf16_autocast);
+        output = module_.forward(ivalues);
+    }
+
+    std::vector<std::pair<std::string, torch::Tensor>> named_outputs;
+    flatten_output(output, "", named_outputs);
+    if (named_outputs.empty())
+    {
+        throw InferenceExecutionException("LibtorchInfer: model returned no tensors");
+    }
+
+    // Reduced precision stays inside the model, callers always get fp32
+    if (options_.bf16_autocast)
+    {
+        for (auto& named_output : named_outputs)
+        {
+            if (named_output.second.scalar_type() == torch::kBFloat16)
+            {
+                named_output.second = named_output.second.to(torch::kFloat32);
+            }
+        }
+    }
+    return named_outputs;
+}
+
+void LibtorchInfer::flatten_output(const torch::jit::IValue& value, const std::string& name, std::vector<std::pair<std::string, torch::Tensor>>& outputs)
+{
+    auto child_name = [&name](const std::string& key) {
+        return name.empty() ? key : name + "." + key;
+    };
+
+    if (value.isTensor())
+    {
+        outputs.emplace_back(name.empty() ? "output" : name, value.toTensor());
+    }
+    else if (value.isTuple())
+    {
+        const auto& elements = value.toTupleRef().elements();
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            flatten_output(elements[i], child_name(std::to_string(i)), outputs);
+        }
+    }
+    else if (value.isList())
+    {
+        const auto elements = value.toListRef();
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            flatten_output(elements[i], child_name(std::to_string(i)), outputs);
+        }
+    }
+    else if (value.isGenericDict())
+    {
+        for (const auto& item : value.toGenericDict())
+        {
+            std::string key;
+            if (item.key().isString())
+            {
+                key = item.key().toStringRef();
+            }
+            else
+            {
+                std::stringstream ss;
+                ss << item.key();
+                key = ss.str();
+            }
+            flatten_output(item.value(), child_name(key), outputs);
+        }
+    }
+    else if (value.isInt() || value.isBool())
+    {
+        outputs.emplace_back(name.empty() ? "output" : name, torch::tensor(value.isInt() ? value.toInt() : static_cast<int64_t>(value.toBool())));
+    }
+    else if (value.isDouble())
+    {
+        outputs.emplace_back(name.empty() ? "output" : name, torch::tensor(static_cast<float>(value.toDouble())));
+    }
+    else if (!value.isNone())
+    {
+        LOG(WARNING) << "Skipping unsupported output " << name << " of type " << value.tagKind();
+    }
+}
@@ -3,17 +3,51 @@
 #include <torch/torch.h>
 #include <torch/script.h>
 
+struct LibtorchOptions {
+    // Freeze the module and run optimize_for_inference at load time (constant folding, conv/bn folding,
+    // oneDNN layout propagation on CPU) instead of re-specializing the profiling executor on every call
+    bool optimize = false;
+    // Let the oneDNN Graph (LLGA) fuser take over fusable CPU subgraphs
+    bool onednn_fusion = false;
+    // ATen thread pools, 0 keeps the LibTorch defaults. Both are process-wide settings.
+    int intra_op_threads = 0;
+    int inter_op_threads = 0;
+    // Convert 4D weights and image inputs to channels_last, the layout oneDNN convolutions run natively.
+    // The image input is then declared NHWC, and NHWC blobs are wrapped without a copy.
+    bool channels_last = false;
+    // Run forward under CPU autocast to bfloat16; pays off on CPUs with AMX or AVX512-BF16.
+    // Floating outputs are converted back to fp32 when leaving forward()
+    bool bf16_autocast = false;
+};
+
 class LibtorchInfer : public InferenceInterface
 {
 public:
     LibtorchInfer(const std::string& model_path, 
         bool use_gpu = false, 
         size_t batch_size = 1, 
-        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>());
+        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>(),
+        const LibtorchOptions& options = LibtorchOptions());
     std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
 
+    // Feeds the image followed by the remaining forward() inputs in declaration order, with their own dtypes
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob,
+        const std::vector<torch::Tensor>& auxiliary_inputs);
+
+    // Native forward: every declared input in order, outputs flattened into named tensors left on the
+    // model device. Tuple/List elements are named by index and Dict entries by key, joined with '.'
+    // for nested containers ("0", "boxes", "1.scores"); a single tensor output is named "output".
+    std::vector<std::pair<std::string, torch::Tensor>> forward(const std::vector<torch::Tensor>& inputs);
+
 private:
     std::string print_shape(const std::vector<int64_t>& shape);
+    void configure_threads();
+    void optimize_module();
+    void convert_to_channels_last();
+    void flatten_output(const torch::jit::IValue& value, const std::string& name, std::vector<std::pair<std::string, torch::Tensor>>& outputs);
+    size_t num_forward_inputs_ = 0;
+    int64_t image_channels_ = 0;  // Of the first input, 0 when its shape is unknown
+    LibtorchOptions options_;
     torch::DeviceType device_;
     torch::jit::script::Module module_;    
   
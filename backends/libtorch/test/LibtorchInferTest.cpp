@@ -180,6 +180,90 @@ TEST_F(LibtorchInferTest, GPUTest) {
     }
 }
 
+// Frozen/optimized module with a real batch - only runs with real model
+TEST_F(LibtorchInferTest, OptimizedBatchInference) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping optimized inference test - no real model available";
+    }
+
+    LibtorchOptions options;
+    options.optimize = true;
+    options.intra_op_threads = 2;
+    std::vector<std::vector<int64_t>> input_sizes = {{1, 3, 224, 224}};
+    auto optimized_infer = std::make_unique<LibtorchInfer>(model_path, false, 2, input_sizes, options);
+
+    cv::Mat first = cv::Mat::zeros(224, 224, CV_32FC3);
+    cv::Mat second = cv::Mat::ones(224, 224, CV_32FC3);
+    cv::Mat batch_blob;
+    cv::dnn::blobFromImages(std::vector<cv::Mat>{first, second}, batch_blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [batch_outputs, batch_shapes] = optimized_infer->get_infer_results(batch_blob);
+    ASSERT_EQ(batch_shapes[0][0], 2);
+    ASSERT_EQ(batch_outputs[0].size(), 2000);
+
+    // First batch entry matches the unoptimized single-image result
+    cv::Mat blob;
+    cv::dnn::blobFromImage(first, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+    auto [reference_outputs, reference_shapes] = real_infer->get_infer_results(blob);
+    for (size_t i = 0; i < 1000; ++i) {
+        ASSERT_NEAR(std::get<float>(batch_outputs[0][i]), std::get<float>(reference_outputs[0][i]), 1e-3f);
+    }
+}
+
+// Native forward with named outputs - only runs with real model
+TEST_F(LibtorchInferTest, NamedForward) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping named forward test - no real model available";
+    }
+
+    torch::Tensor input = torch::zeros({1, 3, 224, 224});
+    auto named_outputs = real_infer->forward({input});
+    ASSERT_EQ(named_outputs.size(), 1);
+    ASSERT_EQ(named_outputs[0].first, "output");
+    ASSERT_EQ(named_outputs[0].second.size(1), 1000);
+
+    // Every declared input must be fed
+    ASSERT_THROW(real_infer->forward({input, input}), InferenceExecutionException);
+}
+
+// channels_last and bf16 autocast against the fp32 reference - only runs with real model
+TEST_F(LibtorchInferTest, ChannelsLastBF16) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping channels_last/bf16 test - no real model available";
+    }
+
+    LibtorchOptions options;
+    options.channels_last = true;
+    options.bf16_autocast = true;
+    std::vector<std::vector<int64_t>> input_sizes = {{1, 3, 224, 224}};
+    auto bf16_infer = std::make_unique<LibtorchInfer>(model_path, false, 1, input_sizes, options);
+
+    cv::Mat input(224, 224, CV_32FC3);
+    cv::randu(input, cv::Scalar::all(0.f), cv::Scalar::all(255.f));
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [bf16_outputs, bf16_shapes] = bf16_infer->get_infer_results(blob);
+    auto [reference_outputs, reference_shapes] = real_infer->get_infer_results(blob);
+    ASSERT_EQ(bf16_shapes, reference_shapes);
+
+    // The image input is declared NHWC, and an NHWC blob gives the same outputs as the NCHW one
+    ASSERT_EQ(bf16_infer->get_model_info().getInputs()[0].layout, TensorLayout::NHWC);
+    auto [nhwc_outputs, nhwc_shapes] = bf16_infer->get_infer_results(bf16_infer->blob_from_image(input, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true));
+    ASSERT_EQ(nhwc_shapes, bf16_shapes);
+    for (size_t i = 0; i < bf16_outputs[0].size(); ++i) {
+        ASSERT_NEAR(std::get<float>(nhwc_outputs[0][i]), std::get<float>(bf16_outputs[0][i]), 1e-3f);
+    }
+
+    // Outputs come back as fp32 and stay close to the fp32 model at bf16 precision
+    auto top1 = [](const std::vector<TensorElement>& scores) {
+        return std::distance(scores.begin(), std::max_element(scores.begin(), scores.end(),
+            [](const TensorElement& a, const TensorElement& b) { return std::get<float>(a) < std::get<float>(b); }));
+    };
+    ASSERT_TRUE(std::holds_alternative<float>(bf16_outputs[0][0]));
+    ASSERT_EQ(top1(bf16_outputs[0]), top1(reference_outputs[0]));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
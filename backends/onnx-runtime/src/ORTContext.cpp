@@ -0,0 +1,47 @@
+#include "ORTContext.hpp"
+#include <glog/logging.h>
+
+std::mutex ORTContext::mutex_;
+std::weak_ptr<ORTContext> ORTContext::instance_;
+ORTContextOptions ORTContext::options_;
+
+ORTContext::ORTContext(const ORTContextOptions& options)
+{
+    Ort::ThreadingOptions threading_options;
+    threading_options.SetGlobalIntraOpNumThreads(options.intra_op_threads);
+    threading_options.SetGlobalInterOpNumThreads(options.inter_op_threads);
+    threading_options.SetGlobalSpinControl(options.allow_spinning ? 1 : 0);
+
+    env_ = Ort::Env(threading_options, ORT_LOGGING_LEVEL_WARNING, "Onnx Runtime Inference");
+    LOG(INFO) << "Created shared ONNX Runtime context (intra-op threads: " << options.intra_op_threads
+              << ", inter-op threads: " << options.inter_op_threads << ")";
+}
+
+std::shared_ptr<ORTContext> ORTContext::instance()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<ORTContext> context = instance_.lock();
+    if (!context)
+    {
+        context.reset(new ORTContext(options_));
+        instance_ = context;
+    }
+    return context;
+}
+
+void ORTContext::configure(const ORTContextOptions& options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!instance_.expired())
+    {
+        LOG(WARNING) << "ONNX Runtime context already created, new thread settings apply once all sessions are released";
+    }
+    options_ = options;
+}
+
+Ort::SessionOptions ORTContext::make_session_options() const
+{
+    Ort::SessionOptions session_options;
+    session_options.DisablePerSessionThreads();
+    return session_options;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <onnxruntime_cxx_api.h>
+#include <memory>
+#include <mutex>
+
+struct ORTContextOptions {
+    // Size of the global intra-op/inter-op pools, 0 lets ONNX Runtime pick (one thread per physical core)
+    int intra_op_threads = 0;
+    int inter_op_threads = 0;
+    // Spinning lowers latency but burns cores while sessions are idle
+    bool allow_spinning = true;
+};
+
+// Process-wide ONNX Runtime state shared by every ORTInfer: one Env with global thread pools
+// and one prepacked weights container, so replicas of a model keep a single prepacked copy.
+// The context lives as long as at least one ORTInfer holds it.
+class ORTContext {
+public:
+    // Returns the live context, creating it with the configured options if needed
+    static std::shared_ptr<ORTContext> instance();
+
+    // Options used the next time the context is created; has no effect on a live context
+    static void configure(const ORTContextOptions& options);
+
+    Ort::Env& env() noexcept { return env_; }
+    Ort::PrepackedWeightsContainer& prepacked_weights() noexcept { return prepacked_weights_; }
+
+    // Session options bound to the global thread pools
+    Ort::SessionOptions make_session_options() const;
+
+    ORTContext(const ORTContext&) = delete;
+    ORTContext& operator=(const ORTContext&) = delete;
+
+private:
+    explicit ORTContext(const ORTContextOptions& options);
+
+    Ort::Env env_{ nullptr };
+    Ort::PrepackedWeightsContainer prepacked_weights_;
+
+    static std::mutex mutex_;
+    static std::weak_ptr<ORTContext> instance_;
+    static ORTContextOptions options_;
+};
@@ -1,50 +1,51 @@
 #include "ORTInfer.hpp"
 #include <numeric>   
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
 
-ORTInfer::ORTInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes) : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
+namespace {
+// Maps the short provider names accepted in ORTOptions to the names reported by Ort::GetAvailableProviders()
+const std::unordered_map<std::string, std::string> kProviderNames = {
+    {"CPU", "CPUExecutionProvider"},
+    {"CUDA", "CUDAExecutionProvider"},
+    {"XNNPACK", "XnnpackExecutionProvider"},
+    {"DNNL", "DnnlExecutionProvider"},
+    {"OpenVINO", "OpenVINOExecutionProvider"}
+};
+}
+
+ORTInfer::ORTInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes, const ORTOptions& options) 
+    : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
+    , options_(options)
 {
-    env_ = Ort::Env(ORT_LOGGING_LEVEL_WARNING, "Onnx Runtime Inference");
-    Ort::SessionOptions session_options;
+    // Env, thread pools and prepacked weights are shared with every other ORTInfer in the process
+    context_ = ORTContext::instance();
 
-    if (use_gpu)
+    const std::vector<ORTExecutionProvider> candidates = resolveProviders(use_gpu);
+
+    // Walk the priority list until a provider accepts the model
+    size_t selected = 0;
+    for (; selected < candidates.size(); ++selected)
     {
-        std::vector<std::string> providers = Ort::GetAvailableProviders();
-        LOG(INFO) << "Available providers:";
-        bool is_found = false;
-        for (const auto& p : providers)
+        try
         {
-            LOG(INFO) << p;
-            if (p.find("CUDA") != std::string::npos)
-            {
-                LOG(INFO) << "Using CUDA GPU";
-                OrtCUDAProviderOptions cuda_options;
-                session_options.AppendExecutionProvider_CUDA(cuda_options);
-                is_found = true;
-                break;
-            }
+            session_ = createSession(model_path, candidates[selected]);
+            execution_provider_ = candidates[selected].name;
+            break;
         }
-        if (!is_found)
+        catch (const Ort::Exception& ex)
         {
-            LOG(INFO) << "CUDA GPU not available, falling back to CPU";
-            session_options = Ort::SessionOptions();
+            LOG(WARNING) << "Failed to create session with " << candidates[selected].name << " execution provider: " << ex.what();
         }
     }
-    else
-    {
-        LOG(INFO) << "Using CPU";
-        session_options = Ort::SessionOptions();
-    }
-
-    try
-    {
-        session_ = Ort::Session(env_, model_path.c_str(), session_options);
-    }
-    catch (const Ort::Exception& ex)
+    if (selected == candidates.size())
     {
-        LOG(ERROR) << "Failed to load the ONNX model: " << ex.what();
+        LOG(ERROR) << "Failed to load the ONNX model: " << model_path;
         std::exit(1);
     }
+    LOG(INFO) << "Using execution provider " << execution_provider_;
 
     Ort::AllocatorWithDefaultOptions allocator;
     LOG(INFO) << "Input Node Name/Shape (" << session_.GetInputCount() << "):";
@@ -125,6 +126,207 @@ ORTInfer::ORTInfer(const std::string& model_path, bool use_gpu, size_t batch_siz
         LOG(INFO) << "\t" << name << " : " << print_shape(shapes);
         model_info_.addOutput(name, shapes, batch_size);
     }
+
+    if (options_.auto_select && selected + 1 < candidates.size())
+    {
+        selectFastestProvider(model_path, candidates, selected);
+    }
+}
+
+std::vector<ORTExecutionProvider> ORTInfer::resolveProviders(bool use_gpu)
+{
+    const std::vector<std::string> available = Ort::GetAvailableProviders();
+    LOG(INFO) << "Available providers:";
+    for (const auto& p : available)
+    {
+        LOG(INFO) << p;
+    }
+
+    auto is_available = [&available](const std::string& name) {
+        auto it = kProviderNames.find(name);
+        if (it == kProviderNames.end())
+        {
+            LOG(WARNING) << "Unknown execution provider '" << name << "', ignoring it";
+            return false;
+        }
+        return std::find(available.begin(), available.end(), it->second) != available.end();
+    };
+
+    std::vector<ORTExecutionProvider> requested;
+    if (use_gpu)
+    {
+        requested.push_back({"CUDA", {}});
+    }
+    requested.insert(requested.end(), options_.providers.begin(), options_.providers.end());
+    if (options_.auto_select && options_.providers.empty())
+    {
+        // No explicit list: benchmark every CPU-side provider this build ships with
+        for (const char* name : {"XNNPACK", "DNNL", "OpenVINO"})
+        {
+            requested.push_back({name, {}});
+        }
+    }
+
+    std::vector<ORTExecutionProvider> candidates;
+    for (const auto& provider : requested)
+    {
+        const bool duplicate = std::any_of(candidates.begin(), candidates.end(),
+            [&provider](const ORTExecutionProvider& p) { return p.name == provider.name; });
+        if (duplicate)
+        {
+            continue;
+        }
+        if (is_available(provider.name))
+        {
+            candidates.push_back(provider);
+        }
+        else
+        {
+            LOG(INFO) << provider.name << " execution provider not available, skipping";
+        }
+    }
+
+    // The default CPU provider is always the last resort
+    const bool has_cpu = std::any_of(candidates.begin(), candidates.end(),
+        [](const ORTExecutionProvider& p) { return p.name == "CPU"; });
+    if (!has_cpu)
+    {
+        candidates.push_back({"CPU", {}});
+    }
+    return candidates;
+}
+
+Ort::Session ORTInfer::createSession(const std::string& model_path, const ORTExecutionProvider& provider)
+{
+    Ort::SessionOptions session_options = context_->make_session_options();
+    appendExecutionProvider(session_options, provider);
+    return Ort::Session(context_->env(), model_path.c_str(), session_options, context_->prepacked_weights());
+}
+
+void ORTInfer::appendExecutionProvider(Ort::SessionOptions& session_options, const ORTExecutionProvider& provider)
+{
+    if (provider.name == "CPU")
+    {
+        return;
+    }
+    if (provider.name == "CUDA")
+    {
+        OrtCUDAProviderOptions cuda_options;
+        session_options.AppendExecutionProvider_CUDA(cuda_options);
+    }
+    else if (provider.name == "XNNPACK")
+    {
+        session_options.AppendExecutionProvider("XNNPACK", provider.options);
+    }
+    else if (provider.name == "OpenVINO")
+    {
+        session_options.AppendExecutionProvider_OpenVINO_V2(provider.options);
+    }
+    else if (provider.name == "DNNL")
+    {
+        // oneDNN has no C++ wrapper, go through the C API
+        const OrtApi& api = Ort::GetApi();
+        OrtDnnlProviderOptions* dnnl_options = nullptr;
+        Ort::ThrowOnError(api.CreateDnnlProviderOptions(&dnnl_options));
+        std::vector<const char*> keys;
+        std::vector<const char*> values;
+        for (const auto& [key, value] : provider.options)
+        {
+            keys.push_back(key.c_str());
+            values.push_back(value.c_str());
+        }
+        OrtStatus* status = api.UpdateDnnlProviderOptions(dnnl_options, keys.data(), values.data(), keys.size());
+        if (status == nullptr)
+        {
+            status = api.SessionOptionsAppendExecutionProvider_Dnnl(session_options, dnnl_options);
+        }
+        api.ReleaseDnnlProviderOptions(dnnl_options);
+        Ort::ThrowOnError(status);
+    }
+}
+
+void ORTInfer::selectFastestProvider(const std::string& model_path, const std::vector<ORTExecutionProvider>& candidates, size_t selected)
+{
+    // A selected provider that fails its first run is beaten by any candidate that works
+    double best_time_ms = std::numeric_limits<double>::infinity();
+    try
+    {
+        best_time_ms = benchmarkSession(session_);
+        LOG(INFO) << "Benchmark " << execution_provider_ << ": " << best_time_ms << " ms";
+    }
+    catch (const Ort::Exception& ex)
+    {
+        LOG(WARNING) << "Benchmark " << execution_provider_ << " failed: " << ex.what();
+    }
+
+    for (size_t i = selected + 1; i < candidates.size(); ++i)
+    {
+        try
+        {
+            Ort::Session session = createSession(model_path, candidates[i]);
+            const double time_ms = benchmarkSession(session);
+            LOG(INFO) << "Benchmark " << candidates[i].name << ": " << time_ms << " ms";
+            if (time_ms < best_time_ms)
+            {
+                best_time_ms = time_ms;
+                session_ = std::move(session);
+                execution_provider_ = candidates[i].name;
+            }
+        }
+        catch (const Ort::Exception& ex)
+        {
+            LOG(WARNING) << "Skipping " << candidates[i].name << " execution provider: " << ex.what();
+        }
+    }
+    LOG(INFO) << "Selected execution provider " << execution_provider_ << " (" << best_time_ms << " ms)";
+}
+
+double ORTInfer::benchmarkSession(Ort::Session& session)
+{
+    const auto& inputs = model_info_.getInputs();
+    const auto& outputs = model_info_.getOutputs();
+
+    // Zero-filled inputs are enough to time the graph, values do not change the work done
+    Ort::AllocatorWithDefaultOptions allocator;
+    std::vector<Ort::Value> in_ort_tensors;
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const auto type = session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType();
+        Ort::Value tensor = Ort::Value::CreateTensor(allocator, inputs[i].shape.data(), inputs[i].shape.size(), type);
+        std::memset(tensor.GetTensorMutableRawData(), 0, getSizeByDim(inputs[i].shape) * getElementSize(type));
+        in_ort_tensors.emplace_back(std::move(tensor));
+    }
+
+    std::vector<const char*> input_names_char(inputs.size());
+    std::transform(inputs.begin(), inputs.end(), input_names_char.begin(),
+    [](const LayerInfo& layer) { return layer.name.c_str(); });
+
+    std::vector<const char*> output_names_char(outputs.size());
+    std::transform(outputs.begin(), outputs.end(), output_names_char.begin(),
+    [](const LayerInfo& layer) { return layer.name.c_str(); });
+
+    auto run = [&]() {
+        session.Run(Ort::RunOptions{ nullptr }, input_names_char.data(), in_ort_tensors.data(), in_ort_tensors.size(),
+            output_names_char.data(), output_names_char.size());
+    };
+
+    for (int i = 0; i < options_.benchmark_warmup; ++i)
+    {
+        run();
+    }
+
+    std::vector<double> times_ms;
+    for (int i = 0; i < std::max(1, options_.benchmark_iterations); ++i)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        run();
+        const auto end = std::chrono::high_resolution_clock::now();
+        times_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    // Median is robust against the odd scheduling hiccup
+    std::nth_element(times_ms.begin(), times_ms.begin() + times_ms.size() / 2, times_ms.end());
+    return times_ms[times_ms.size() / 2];
 }
 
 
@@ -141,6 +343,28 @@ std::string ORTInfer::getDataTypeString(ONNXTensorElementDataType type)
     }
 }
 
+size_t ORTInfer::getElementSize(ONNXTensorElementDataType type)
+{
+    switch (type)
+    {
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+            return 8;
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+            return 4;
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+        case ONNXTensorElementDataType::ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
 std::string ORTInfer::print_shape(const std::vector<std::int64_t>& v)
 {
     std::stringstream ss("");
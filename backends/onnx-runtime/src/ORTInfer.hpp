@@ -2,28 +2,59 @@
 #include "InferenceInterface.hpp"
 #include <onnxruntime_cxx_api.h>  // for ONNX Runtime C++ API
 #include <onnxruntime_c_api.h>    // for CUDA execution provider (if using CUDA)
+#include "ORTContext.hpp"
 #include <glog/logging.h>
+#include <unordered_map>
+
+// Execution provider requested by short name: "CPU", "CUDA", "XNNPACK", "DNNL" (oneDNN) or "OpenVINO".
+// Options are forwarded verbatim to the provider (e.g. {"intra_op_num_threads", "4"} for XNNPACK).
+struct ORTExecutionProvider {
+    std::string name;
+    std::unordered_map<std::string, std::string> options;
+};
+
+struct ORTOptions {
+    // Priority list, first available provider wins. Empty keeps the CUDA/CPU default.
+    std::vector<ORTExecutionProvider> providers;
+    // Benchmark every available candidate on the loaded model and keep the fastest one
+    bool auto_select = false;
+    int benchmark_warmup = 2;
+    int benchmark_iterations = 10;
+};
 
 class ORTInfer : public InferenceInterface
 {
 public:
     std::string print_shape(const std::vector<std::int64_t>& v);
-    ORTInfer(const std::string& model_path, 
-        bool use_gpu = false, 
-        size_t batch_size = 1, 
-        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>());
+    ORTInfer(const std::string& model_path,
+        bool use_gpu = false,
+        size_t batch_size = 1,
+        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>(),
+        const ORTOptions& options = ORTOptions());
     size_t getSizeByDim(const std::vector<int64_t>& dims);
     std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
 
+    // Short name of the execution provider the active session was built with
+    const std::string& get_execution_provider() const noexcept { return execution_provider_; }
+
 private:
-    Ort::Env env_;
+    std::shared_ptr<ORTContext> context_;
     Ort::Session session_{ nullptr };
+    ORTOptions options_;
+    std::string execution_provider_;
     static std::string getDataTypeString(ONNXTensorElementDataType type);
+    static size_t getElementSize(ONNXTensorElementDataType type);
+
+    std::vector<ORTExecutionProvider> resolveProviders(bool use_gpu);
+    Ort::Session createSession(const std::string& model_path, const ORTExecutionProvider& provider);
+    void appendExecutionProvider(Ort::SessionOptions& session_options, const ORTExecutionProvider& provider);
+    void selectFastestProvider(const std::string& model_path, const std::vector<ORTExecutionProvider>& candidates, size_t selected);
+    double benchmarkSession(Ort::Session& session);
 
     template<typename T>
     void processTensorData(std::vector<TensorElement>& tensor_data, const T* data, size_t num_elements) {
         for (size_t i = 0; i < num_elements; ++i) {
             tensor_data.emplace_back(data[i]);
         }
-    }    
-};
\ No newline at end of file
+    }
+};
@@ -218,6 +218,68 @@ TEST_F(ONNXRuntimeInferTest, BatchSizeHandling) {
     }
 }
 
+// Execution provider selection - only runs with real model
+TEST_F(ONNXRuntimeInferTest, ExecutionProviderSelection) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping execution provider test - no real model available";
+    }
+
+    // Providers missing from this ORT build are skipped, CPU is always the fallback
+    ORTOptions options;
+    options.providers = {{"XNNPACK", {{"intra_op_num_threads", "2"}}}, {"DNNL", {}}};
+    auto ep_infer = std::make_unique<ORTInfer>(model_path, false, 1, std::vector<std::vector<int64_t>>(), options);
+    ASSERT_FALSE(ep_infer->get_execution_provider().empty());
+
+    cv::Mat input = cv::Mat::zeros(224, 224, CV_32FC3);
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [output_vectors, shape_vectors] = ep_infer->get_infer_results(blob);
+    ASSERT_EQ(output_vectors[0].size(), 1000);
+}
+
+// Auto mode benchmarks the available providers - only runs with real model
+TEST_F(ONNXRuntimeInferTest, ExecutionProviderAutoSelect) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping execution provider auto-select test - no real model available";
+    }
+
+    ORTOptions options;
+    options.auto_select = true;
+    options.benchmark_iterations = 3;
+    auto auto_infer = std::make_unique<ORTInfer>(model_path, false, 1, std::vector<std::vector<int64_t>>(), options);
+    ASSERT_FALSE(auto_infer->get_execution_provider().empty());
+
+    cv::Mat input = cv::Mat::zeros(224, 224, CV_32FC3);
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [output_vectors, shape_vectors] = auto_infer->get_infer_results(blob);
+    ASSERT_EQ(output_vectors[0].size(), 1000);
+}
+
+// Replicas share the process-wide Env, thread pools and prepacked weights - only runs with real model
+TEST_F(ONNXRuntimeInferTest, SharedContextReplicas) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping shared context test - no real model available";
+    }
+
+    auto replica = std::make_unique<ORTInfer>(model_path, false);
+
+    cv::Mat input = cv::Mat::ones(224, 224, CV_32FC3);
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [first_outputs, first_shapes] = real_infer->get_infer_results(blob);
+    auto [replica_outputs, replica_shapes] = replica->get_infer_results(blob);
+
+    ASSERT_EQ(first_shapes, replica_shapes);
+    ASSERT_EQ(first_outputs[0].size(), replica_outputs[0].size());
+    for (size_t i = 0; i < first_outputs[0].size(); ++i) {
+        ASSERT_FLOAT_EQ(std::get<float>(first_outputs[0][i]), std::get<float>(replica_outputs[0][i]));
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -1,6 +1,47 @@
 #include "OCVDNNInfer.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
-OCVDNNInfer::OCVDNNInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes) : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
+namespace {
+
+const std::unordered_map<std::string, cv::dnn::Backend> kBackendNames = {
+    {"OPENCV", cv::dnn::DNN_BACKEND_OPENCV},
+    {"INFERENCE_ENGINE", cv::dnn::DNN_BACKEND_INFERENCE_ENGINE},
+    {"CUDA", cv::dnn::DNN_BACKEND_CUDA},
+    {"VKCOM", cv::dnn::DNN_BACKEND_VKCOM},
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+    {"TIMVX", cv::dnn::DNN_BACKEND_TIMVX},
+#endif
+};
+
+const std::unordered_map<std::string, cv::dnn::Target> kTargetNames = {
+    {"CPU", cv::dnn::DNN_TARGET_CPU},
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 8)
+    {"CPU_FP16", cv::dnn::DNN_TARGET_CPU_FP16},
+#endif
+    {"OPENCL", cv::dnn::DNN_TARGET_OPENCL},
+    {"OPENCL_FP16", cv::dnn::DNN_TARGET_OPENCL_FP16},
+    {"MYRIAD", cv::dnn::DNN_TARGET_MYRIAD},
+    {"VULKAN", cv::dnn::DNN_TARGET_VULKAN},
+    {"CUDA", cv::dnn::DNN_TARGET_CUDA},
+    {"CUDA_FP16", cv::dnn::DNN_TARGET_CUDA_FP16},
+};
+
+// Names from newer OpenCV releases than this build: valid, but never available here
+const std::unordered_set<std::string> kNewerNames = {
+#if CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR < 6
+    "TIMVX",
+#endif
+#if CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR < 8
+    "CPU_FP16",
+#endif
+};
+
+} // namespace
+
+OCVDNNInfer::OCVDNNInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes,
+    const OCVDNNOptions& options) : InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
 {
         // check if model path has .weights extension
         std::string modelConfiguration = "";
@@ -20,16 +61,15 @@ OCVDNNInfer::OCVDNNInfer(const std::string& model_path, bool use_gpu, size_t bat
             throw std::runtime_error("Can't load the model: " + model_path);
         }
 
-        if (use_gpu && isCudaBuildEnabled() )
-        {
-            net_.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-            net_.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
-        }
-        else
+        if (options.num_threads > 0)
         {
-            net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-            net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            cv::setNumThreads(options.num_threads);
         }
+        selectBackendAndTarget(use_gpu, options);
+        net_.enableFusion(options.fusion);
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+        net_.enableWinograd(options.winograd);
+#endif
 
         outLayers_ = net_.getUnconnectedOutLayers();
         outLayerType_ = net_.getLayer(outLayers_[0])->type;
@@ -37,26 +77,169 @@ OCVDNNInfer::OCVDNNInfer(const std::string& model_path, bool use_gpu, size_t bat
 
         if (input_sizes.empty())
         {   
-            throw("With OpenCV DNN backend, input sizes must be specified");
+            throw ModelLoadException("With OpenCV DNN backend, input sizes must be specified");
         }
 
+        std::vector<cv::dnn::MatShape> net_input_shapes;
         for (size_t i = 0; i < input_sizes.size(); i++)
         {
             std::vector<int64_t> shape = input_sizes[i];
             model_info_.addInput("input" + std::to_string(i + 1), shape, batch_size);
+
+            cv::dnn::MatShape net_shape{static_cast<int>(batch_size)};
+            net_shape.insert(net_shape.end(), shape.begin(), shape.end());
+            net_input_shapes.push_back(net_shape);
         }
 
-        for (auto& outName : outNames_) {
+        // Output shapes (excluding batch) inferred from the input sizes, placeholders if the importer can't
+        for (size_t i = 0; i < outNames_.size(); ++i) {
             std::vector<int64_t> shape{-1, -1, -1};
-            model_info_.addOutput(outName, shape, batch_size);
+            try
+            {
+                std::vector<cv::dnn::MatShape> in_shapes, out_shapes;
+                net_.getLayerShapes(net_input_shapes, outLayers_[i], in_shapes, out_shapes);
+                if (!out_shapes.empty() && !out_shapes[0].empty())
+                {
+                    shape.assign(out_shapes[0].begin() + 1, out_shapes[0].end());
+                }
+            }
+            catch (const cv::Exception& e)
+            {
+                LOG(WARNING) << "Can't infer the shape of output " << outNames_[i] << ": " << e.what();
+            }
+            model_info_.addOutput(outNames_[i], shape, batch_size);
         }
 
+        computeLayerStats(net_input_shapes);
+}
+
+void OCVDNNInfer::computeLayerStats(const std::vector<cv::dnn::MatShape>& net_input_shapes)
+{
+    try
+    {
+        std::vector<int> layer_ids;
+        std::vector<std::vector<cv::dnn::MatShape>> in_shapes, out_shapes;
+        net_.getLayersShapes(net_input_shapes, layer_ids, in_shapes, out_shapes);
+
+        std::vector<int> memory_ids;
+        std::vector<size_t> weights, blobs;
+        net_.getMemoryConsumption(net_input_shapes, memory_ids, weights, blobs);
+        std::unordered_map<int, size_t> memory_index;
+        for (size_t i = 0; i < memory_ids.size(); ++i)
+        {
+            memory_index[memory_ids[i]] = i;
+        }
+
+        for (size_t i = 0; i < layer_ids.size(); ++i)
+        {
+            // Id 0 is the network input pseudo-layer
+            if (layer_ids[i] == 0)
+            {
+                continue;
+            }
+            const auto layer = net_.getLayer(layer_ids[i]);
+            OCVDNNLayerStats stats;
+            stats.name = layer->name;
+            stats.type = layer->type;
+            if (!out_shapes[i].empty())
+            {
+                stats.output_shape.assign(out_shapes[i][0].begin(), out_shapes[i][0].end());
+            }
+            stats.flops = net_.getFLOPS(layer_ids[i], net_input_shapes);
+            const auto memory_it = memory_index.find(layer_ids[i]);
+            if (memory_it != memory_index.end())
+            {
+                stats.weights_bytes = weights[memory_it->second];
+                stats.blobs_bytes = blobs[memory_it->second];
+            }
+            total_flops_ += stats.flops;
+            layer_stats_.push_back(std::move(stats));
+        }
+
+        size_t total_weights = 0, total_blobs = 0;
+        net_.getMemoryConsumption(net_input_shapes, total_weights, total_blobs);
+        LOG(INFO) << "OpenCV DNN model: " << layer_stats_.size() << " layers, " << total_flops_ * 1e-9 << " GFLOPs, "
+                  << total_weights / (1024 * 1024) << " MB weights, " << total_blobs / (1024 * 1024) << " MB blobs";
+    }
+    catch (const cv::Exception& e)
+    {
+        LOG(WARNING) << "Can't compute per-layer statistics: " << e.what();
+        layer_stats_.clear();
+        total_flops_ = 0;
+    }
+}
+
+void OCVDNNInfer::selectBackendAndTarget(bool use_gpu, const OCVDNNOptions& options)
+{
+    cv::dnn::Backend backend = cv::dnn::DNN_BACKEND_OPENCV;
+    cv::dnn::Target target = cv::dnn::DNN_TARGET_CPU;
+    if (options.backend.empty() && options.target.empty())
+    {
+        if (use_gpu && isCudaBuildEnabled())
+        {
+            backend = cv::dnn::DNN_BACKEND_CUDA;
+            target = cv::dnn::DNN_TARGET_CUDA;
+        }
+    }
+    else
+    {
+        const std::string backend_name = options.backend.empty() ? "OPENCV" : options.backend;
+        const std::string target_name = options.target.empty() ? "CPU" : options.target;
+        const auto backend_it = kBackendNames.find(backend_name);
+        const auto target_it = kTargetNames.find(target_name);
+        const bool backend_known = backend_it != kBackendNames.end() || kNewerNames.count(backend_name);
+        const bool target_known = target_it != kTargetNames.end() || kNewerNames.count(target_name);
+        if (!backend_known || !target_known)
+        {
+            throw ModelLoadException("Unknown OpenCV DNN backend/target: " + options.backend + "/" + options.target);
+        }
+
+        bool is_available = backend_it != kBackendNames.end() && target_it != kTargetNames.end();
+        if (is_available)
+        {
+            const auto available = cv::dnn::getAvailableTargets(backend_it->second);
+            is_available = std::find(available.begin(), available.end(), target_it->second) != available.end();
+        }
+        if (is_available)
+        {
+            backend = backend_it->second;
+            target = target_it->second;
+        }
+        else
+        {
+            LOG(WARNING) << "OpenCV DNN backend/target " << backend_name << "/" << target_name
+                         << " is not available in this build, falling back to OPENCV/CPU";
+        }
+    }
+
+    net_.setPreferableBackend(backend);
+    net_.setPreferableTarget(target);
 }
 
 std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> OCVDNNInfer::get_infer_results(const cv::Mat& preprocessed_img)
 {
+    if (preprocessed_img.dims == 4)
+    {
+        return forward(preprocessed_img);
+    }
     cv::Mat blob;
     cv::dnn::blobFromImage(preprocessed_img, blob, 1.0, cv::Size(), cv::Scalar(), false, false);
+    return forward(blob);
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> OCVDNNInfer::get_infer_results(const std::vector<cv::Mat>& images)
+{
+    if (images.empty())
+    {
+        throw InferenceExecutionException("Empty image batch");
+    }
+    cv::Mat blob;
+    cv::dnn::blobFromImages(images, blob, 1.0, cv::Size(), cv::Scalar(), false, false);
+    return forward(blob);
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> OCVDNNInfer::forward(const cv::Mat& blob)
+{
     std::vector<std::vector<TensorElement>> outputs;
     std::vector<std::vector<int64_t>> shapes;
 
@@ -1,6 +1,29 @@
 #pragma once
 #include "InferenceInterface.hpp"
 
+// Backend by name: "OPENCV", "INFERENCE_ENGINE" (OpenVINO), "CUDA", "VKCOM", "TIMVX".
+// Target by name: "CPU", "CPU_FP16", "OPENCL", "OPENCL_FP16", "MYRIAD", "VULKAN", "CUDA", "CUDA_FP16".
+// Empty keeps the default (CUDA when use_gpu and available, OPENCV/CPU otherwise). A pair this OpenCV
+// build does not provide falls back to OPENCV/CPU with a warning.
+struct OCVDNNOptions {
+    std::string backend;
+    std::string target;
+    // cv::setNumThreads, process-wide for every OpenCV parallel region; 0 keeps OpenCV's default
+    int num_threads = 0;
+    bool winograd = true;   // Winograd convolution on CPU (OpenCV >= 4.7)
+    bool fusion = true;     // Layer fusion (conv + bn + activation, ...)
+};
+
+// Per-layer cost for the input sizes given at construction
+struct OCVDNNLayerStats {
+    std::string name;
+    std::string type;
+    std::vector<int64_t> output_shape;  // First output, including batch
+    int64_t flops = 0;
+    size_t weights_bytes = 0;
+    size_t blobs_bytes = 0;
+};
+
 class OCVDNNInfer : public InferenceInterface
 {
 private:
@@ -8,15 +31,31 @@ private:
     std::vector<int> outLayers_;
     std::string outLayerType_;
     std::vector<std::string> outNames_;
+
+    std::vector<OCVDNNLayerStats> layer_stats_;
+    int64_t total_flops_ = 0;
+
+    void selectBackendAndTarget(bool use_gpu, const OCVDNNOptions& options);
+    void computeLayerStats(const std::vector<cv::dnn::MatShape>& net_input_shapes);
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> forward(const cv::Mat& blob);
         
 public:
     OCVDNNInfer(const std::string& model_path, 
         bool use_gpu = false, 
         size_t batch_size = 1, 
-        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>());
+        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>(),
+        const OCVDNNOptions& options = OCVDNNOptions());
 
+    // Accepts a preprocessed HWC image or a ready NCHW blob (any batch size)
     std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
 
+    // Batched forward: the images are packed into one NCHW blob with cv::dnn::blobFromImages
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const std::vector<cv::Mat>& images);
+
+    // FLOPs and memory per layer (cv::dnn::Net::getFLOPS/getMemoryConsumption), empty if shape inference failed
+    const std::vector<OCVDNNLayerStats>& get_layer_stats() const noexcept { return layer_stats_; }
+    int64_t get_flops() const noexcept { return total_flops_; }
+
     bool isCudaBuildEnabled() {
         std::string buildInfo = cv::getBuildInformation();
         size_t cudaPos = buildInfo.find("CUDA:");
@@ -1,11 +1,14 @@
 #include <gtest/gtest.h>
 #include "OCVDNNInfer.hpp"
+#include "ReplicaPool.hpp"
 #include <glog/logging.h>
 #include <opencv2/opencv.hpp>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <thread>
+#include <atomic>
 
 namespace fs = std::filesystem;
 
@@ -151,6 +154,108 @@ TEST_F(OCVDNNInferTest, MockUnitTest) {
     }
 }
 
+// Test batched forward with an explicit CPU backend/target and thread count
+TEST_F(OCVDNNInferTest, BatchedForwardWithOptions) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping batched test - no real model available";
+    }
+
+    OCVDNNOptions options;
+    options.backend = "OPENCV";
+    options.target = "CPU";
+    options.num_threads = 2;
+    auto batched_infer = std::make_unique<OCVDNNInfer>(model_path, false, 2, std::vector<std::vector<int64_t>>{{3, 224, 224}}, options);
+
+    std::vector<cv::Mat> images(2);
+    for (auto& image : images) {
+        image = cv::Mat(224, 224, CV_32FC3);
+        cv::randu(image, cv::Scalar::all(0.f), cv::Scalar::all(1.f));
+    }
+
+    auto [batch_outputs, batch_shapes] = batched_infer->get_infer_results(images);
+    ASSERT_EQ(batch_shapes[0][0], 2);
+
+    // Each batch entry matches a single-image forward
+    const size_t per_image = batch_outputs[0].size() / 2;
+    for (size_t b = 0; b < images.size(); ++b) {
+        auto [outputs, shapes] = batched_infer->get_infer_results(images[b]);
+        ASSERT_EQ(outputs[0].size(), per_image);
+        for (size_t i = 0; i < per_image; ++i) {
+            ASSERT_NEAR(std::get<float>(outputs[0][i]), std::get<float>(batch_outputs[0][b * per_image + i]), 1e-4f);
+        }
+    }
+
+    // Known but possibly missing from this build (OpenCV < 4.8): falls back instead of failing
+    OCVDNNOptions fp16;
+    fp16.target = "CPU_FP16";
+    EXPECT_NO_THROW(OCVDNNInfer(model_path, false, 1, std::vector<std::vector<int64_t>>{{3, 224, 224}}, fp16));
+
+    OCVDNNOptions unknown;
+    unknown.target = "NO_SUCH_TARGET";
+    EXPECT_THROW(OCVDNNInfer(model_path, false, 1, std::vector<std::vector<int64_t>>{{3, 224, 224}}, unknown), ModelLoadException);
+}
+
+// Test output shapes and per-layer statistics inferred from the input sizes
+TEST_F(OCVDNNInferTest, ShapeIntrospection) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping shape introspection test - no real model available";
+    }
+
+    auto shaped_infer = std::make_unique<OCVDNNInfer>(model_path, false, 1, std::vector<std::vector<int64_t>>{{3, 224, 224}});
+    const auto model_info = shaped_infer->get_model_info();
+    ASSERT_EQ(model_info.getInputs()[0].shape, (std::vector<int64_t>{3, 224, 224}));
+
+    cv::Mat input(224, 224, CV_32FC3, cv::Scalar::all(0.5f));
+    auto [outputs, shapes] = shaped_infer->get_infer_results(input);
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        // Reported shapes exclude the batch dimension
+        std::vector<int64_t> expected(shapes[i].begin() + 1, shapes[i].end());
+        ASSERT_EQ(model_info.getOutputs()[i].shape, expected);
+    }
+
+    ASSERT_FALSE(shaped_infer->get_layer_stats().empty());
+    ASSERT_GT(shaped_infer->get_flops(), 0);
+    size_t weights_bytes = 0;
+    for (const auto& layer : shaped_infer->get_layer_stats()) {
+        weights_bytes += layer.weights_bytes;
+    }
+    ASSERT_GT(weights_bytes, 0u);
+}
+
+// Test concurrent requests on OpenCV DNN replicas against a single engine
+TEST_F(OCVDNNInferTest, ReplicaPoolConcurrentInference) {
+    if (!has_real_model) {
+        GTEST_SKIP() << "Skipping replica pool test - no real model available";
+    }
+
+    // The per-replica thread count is not passed on: cv::setNumThreads is process-wide, so the
+    // replicas share OpenCV's one pool instead of each getting its own share
+    const std::vector<std::vector<int64_t>> input_sizes{{3, 224, 224}};
+    ReplicaPool<OCVDNNInfer> pool(2, [&](size_t, int) {
+        return std::make_unique<OCVDNNInfer>(model_path, false, 1, input_sizes);
+    });
+
+    cv::Mat input(224, 224, CV_32FC3, cv::Scalar::all(0.5f));
+    auto [expected, expected_shapes] = pool.get_infer_results(input);
+
+    std::vector<std::thread> workers;
+    std::atomic<bool> mismatch{false};
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < 3; ++i) {
+                auto [outputs, shapes] = pool.get_infer_results(input);
+                if (shapes != expected_shapes || std::get<float>(outputs[0][0]) != std::get<float>(expected[0][0])) {
+                    mismatch = true;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_FALSE(mismatch);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
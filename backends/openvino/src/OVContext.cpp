@@ -0,0 +1,68 @@
+#include "OVContext.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <thread>
+
+std::mutex OVContext::mutex_;
+std::weak_ptr<OVContext> OVContext::instance_;
+OVContextOptions OVContext::options_;
+
+OVContext::OVContext(const OVContextOptions& options)
+    : total_threads_(static_cast<int>(std::thread::hardware_concurrency()))
+{
+    ov::AnyMap cpu_properties;
+    if (options.inference_num_threads) {
+        cpu_properties.emplace(ov::inference_num_threads(*options.inference_num_threads));
+        total_threads_ = *options.inference_num_threads;
+    }
+    if (options.enable_cpu_pinning) {
+        cpu_properties.emplace(ov::hint::enable_cpu_pinning(*options.enable_cpu_pinning));
+    }
+    if (options.enable_hyper_threading) {
+        cpu_properties.emplace(ov::hint::enable_hyper_threading(*options.enable_hyper_threading));
+    }
+    if (!cpu_properties.empty()) {
+        core_.set_property("CPU", cpu_properties);
+    }
+    LOG(INFO) << "Created shared OpenVINO Core (" << total_threads_ << " CPU threads)";
+}
+
+std::shared_ptr<OVContext> OVContext::instance()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<OVContext> context = instance_.lock();
+    if (!context) {
+        context.reset(new OVContext(options_));
+        instance_ = context;
+    }
+    return context;
+}
+
+void OVContext::configure(const OVContextOptions& options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!instance_.expired()) {
+        LOG(WARNING) << "OpenVINO Core already created, new CPU properties apply once all models are released";
+    }
+    options_ = options;
+}
+
+int OVContext::reserve_threads(int threads)
+{
+    std::lock_guard<std::mutex> lock(budget_mutex_);
+    const int granted = std::min(threads, std::max(total_threads_ - reserved_threads_, 0));
+    reserved_threads_ += granted;
+    return granted;
+}
+
+void OVContext::release_threads(int threads)
+{
+    std::lock_guard<std::mutex> lock(budget_mutex_);
+    reserved_threads_ -= threads;
+}
+
+int OVContext::reserved_threads() const
+{
+    std::lock_guard<std::mutex> lock(budget_mutex_);
+    return reserved_threads_;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "openvino/runtime/core.hpp"
+#include <memory>
+#include <mutex>
+#include <optional>
+
+struct OVContextOptions {
+    // Global CPU plugin properties, unset values keep the plugin defaults
+    std::optional<int> inference_num_threads;
+    std::optional<bool> enable_cpu_pinning;
+    std::optional<bool> enable_hyper_threading;
+};
+
+// Owns the ov::Core that compiles every OVInfer model, with the global CPU properties set on it,
+// and the ledger of CPU threads: models with a num_threads/num_streams budget book it through
+// reserve_threads() before compiling and give it back with release_threads(), so the budgets of
+// the loaded models never exceed total_threads(). Freed with the last OVInfer.
+class OVContext {
+public:
+    // The context of the loaded models, or a new one built from the configure() options
+    static std::shared_ptr<OVContext> instance();
+
+    // CPU properties for a Core created after every OVInfer is gone; a live Core keeps its own
+    static void configure(const OVContextOptions& options);
+
+    ov::Core& core() noexcept { return core_; }
+
+    // Threads available to all models: the global inference_num_threads or the hardware concurrency
+    int total_threads() const noexcept { return total_threads_; }
+
+    // Books up to `threads` of the threads not yet reserved and returns how many were granted, 0 when
+    // the budget is exhausted
+    int reserve_threads(int threads);
+    void release_threads(int threads);
+    int reserved_threads() const;
+
+    OVContext(const OVContext&) = delete;
+    OVContext& operator=(const OVContext&) = delete;
+
+private:
+    explicit OVContext(const OVContextOptions& options);
+
+    ov::Core core_;
+    int total_threads_;
+    int reserved_threads_ = 0;
+    mutable std::mutex budget_mutex_;
+
+    static std::mutex mutex_;
+    static std::weak_ptr<OVContext> instance_;
+    static OVContextOptions options_;
+};
@@ -2,6 +2,7 @@
 #include <filesystem>
 #include <sstream>
 #include <numeric>
+#include <cstring>
 
 // Helper function to print ov::Shape and ov::PartialShape
 template <typename ShapeType>
@@ -27,8 +28,9 @@ std::string OVInfer::print_shape(const ShapeType& shape) {
     return ss.str();
 }
 
-OVInfer::OVInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes) : 
+OVInfer::OVInfer(const std::string& model_path, bool use_gpu, size_t batch_size, const std::vector<std::vector<int64_t>>& input_sizes, const OVOptions& options) : 
     InferenceInterface{model_path, use_gpu, batch_size, input_sizes}
+    , options_(options)
 {
     std::filesystem::path fs_path(model_path);
     std::string basename = fs_path.stem().string();
@@ -49,7 +51,9 @@ OVInfer::OVInfer(const std::string& model_path, bool use_gpu, size_t batch_size,
     }    
 
     try {
-        model_ = core_.read_model(model_config);
+        // The Core and its CPU executor are shared with every other OVInfer in the process
+        context_ = OVContext::instance();
+        model_ = context_->core().read_model(model_config);
 
         // --- Handle dynamic shapes before compiling the model ---
         std::map<ov::Output<ov::Node>, ov::PartialShape> all_shapes; // Store dynamic shapes for all inputs
@@ -103,36 +107,89 @@ OVInfer::OVInfer(const std::string& model_path, bool use_gpu, size_t batch_size,
           // Reshape the model with the gathered partial shapes
           model_->reshape(all_shapes);
         }
+
+        if (options_.preprocess.enabled) {
+            apply_preprocessing();
+        }
         
 
         // Set up device
         std::string device = use_gpu ? "GPU" : "CPU";
         LOG(INFO) << "Using device: " << device;
+
+        ov::AnyMap config;
+        if (options_.throughput_mode) {
+            config.emplace(ov::hint::performance_mode(ov::hint::PerformanceMode::THROUGHPUT));
+        }
+        if (options_.num_streams > 0) {
+            config.emplace(ov::num_streams(ov::streams::Num(options_.num_streams)));
+        } else if (options_.throughput_mode) {
+            config.emplace(ov::num_streams(ov::streams::AUTO));
+        }
+        if (options_.num_threads > 0) {
+            config.emplace(ov::inference_num_threads(options_.num_threads));
+        }
         
+        // A budgeted model books its threads on the shared CPU executor before compiling, clamped to
+        // what the other models left; every stream needs at least one thread
+        auto reserve_cpu_budget = [&]() {
+            const int requested = options_.num_threads > 0 ? options_.num_threads : options_.num_streams;
+            if (requested <= 0) {
+                return;
+            }
+            reserved_threads_ = context_->reserve_threads(requested);
+            if (reserved_threads_ == 0) {
+                throw ModelLoadException("OpenVINO CPU budget exhausted: all " + std::to_string(context_->total_threads()) +
+                    " threads are reserved by other models");
+            }
+            if (reserved_threads_ < requested) {
+                LOG(WARNING) << "Only " << reserved_threads_ << " of the " << requested << " requested CPU threads are left, budget clamped";
+            }
+            config[ov::inference_num_threads.name()] = reserved_threads_;
+            if (options_.num_streams > reserved_threads_) {
+                config[ov::num_streams.name()] = ov::streams::Num(reserved_threads_);
+            }
+        };
+
+        if (device == "CPU") {
+            reserve_cpu_budget();
+        }
         try {
-            compiled_model_ = core_.compile_model(model_, device);
+            compiled_model_ = context_->core().compile_model(model_, device, config);
         } catch (const ov::Exception& e) {
             if (use_gpu && device == "GPU") {
                 LOG(WARNING) << "GPU not available, falling back to CPU: " << e.what();
                 device = "CPU";
-                compiled_model_ = core_.compile_model(model_, device);
+                reserve_cpu_budget();
+                compiled_model_ = context_->core().compile_model(model_, device, config);
             } else {
                 throw; // Re-throw if it's not a GPU fallback case
             }
         }
         infer_request_ = compiled_model_.create_infer_request();
+        create_request_pool();
 
         // --- Process inputs after compilation ---
         for (size_t i = 0; i < model_->inputs().size(); ++i) {
             auto input = model_->input(i);
             std::string name = input.get_any_name();
             ov::Shape shape = input.get_shape();
+            const bool raw_image = i == 0 && options_.preprocess.enabled;
+            if (raw_image) {
+                // Report the network geometry channel-first like every image input; the layout and
+                // element type tell blob builders the tensor takes the u8 NHWC BGR image
+                shape = ov::Shape{shape[0], shape[3], shape[1], shape[2]};
+            }
 
             // Convert ov::Shape to std::vector<int64_t>
             std::vector<int64_t> shape_vec(shape.begin() + 1, shape.end());
 
             LOG(INFO) << "\t" << name << " : " << print_shape(shape);
-            model_info_.addInput(name, shape_vec, batch_size); // Pass the converted shape_vec
+            if (raw_image) {
+                model_info_.addInput(name, shape_vec, batch_size, TensorLayout::NHWC, TensorElementType::U8);
+            } else {
+                model_info_.addInput(name, shape_vec, batch_size); // Pass the converted shape_vec
+            }
 
             ov::element::Type input_type = input.get_element_type();
             LOG(INFO) << "\tData Type: " << input_type.get_type_name();
@@ -172,39 +229,216 @@ OVInfer::OVInfer(const std::string& model_path, bool use_gpu, size_t batch_size,
         LOG(ERROR) << "Failed to load or process the OpenVINO model: " << e.what();
         std::exit(1);
     }
+    catch (...) {
+        // The destructor does not run for a failed constructor
+        if (context_) {
+            context_->release_threads(reserved_threads_);
+        }
+        throw;
+    }
 }
 
-std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> OVInfer::get_infer_results(const cv::Mat& input_blob) 
+void OVInfer::apply_preprocessing()
 {
-    std::vector<std::vector<TensorElement>> outputs;
-    std::vector<std::vector<int64_t>> shapes;
+    const auto& preprocess = options_.preprocess;
+    ov::preprocess::PrePostProcessor ppp(model_);
+    auto& input = ppp.input(0);
 
-    // The input_blob is already in the correct format (NCHW)
-    // No need to convert again
+    input.tensor()
+        .set_element_type(ov::element::u8)
+        .set_layout("NHWC")
+        .set_color_format(ov::preprocess::ColorFormat::BGR);
+    input.model().set_layout(ov::Layout(preprocess.model_layout));
+
+    auto& steps = input.preprocess();
+    steps.convert_element_type(ov::element::f32);
+    if (preprocess.bgr_to_rgb) {
+        steps.convert_color(ov::preprocess::ColorFormat::RGB);
+    }
+    if (!preprocess.mean.empty()) {
+        steps.mean(preprocess.mean);
+    }
+    if (!preprocess.scale.empty()) {
+        steps.scale(preprocess.scale);
+    }
+
+    model_ = ppp.build();
+    LOG(INFO) << "Embedded preprocessing: " << ppp;
+}
+
+OVInfer::~OVInfer()
+{
+    // Completion callbacks reference this object, drain them before members go away, then let every
+    // request finish its own bookkeeping before the requests and the compiled model are destroyed
+    wait_all();
+    for (auto& slot : async_slots_) {
+        try {
+            slot->request.wait();
+        } catch (const std::exception& e) {
+            LOG(WARNING) << "Waiting for an infer request failed: " << e.what();
+        }
+    }
+    if (context_) {
+        context_->release_threads(reserved_threads_);
+    }
+}
+
+void OVInfer::create_request_pool()
+{
+    size_t num_requests = options_.num_requests;
+    if (num_requests == 0) {
+        num_requests = compiled_model_.get_property(ov::optimal_number_of_infer_requests);
+    }
+    num_requests = std::max<size_t>(num_requests, 1);
+
+    LOG(INFO) << "Streams: " << compiled_model_.get_property(ov::num_streams).num
+              << ", async infer requests: " << num_requests;
+
+    for (size_t i = 0; i < num_requests; ++i) {
+        auto slot = std::make_unique<AsyncSlot>();
+        slot->request = compiled_model_.create_infer_request();
+        slot->request.set_callback([this, i](std::exception_ptr error) {
+            AsyncSlot& done = *async_slots_[i];
+            if (error) {
+                done.promise.set_exception(error);
+            } else {
+                try {
+                    done.promise.set_value(extract_outputs(done.request));
+                } catch (...) {
+                    done.promise.set_exception(std::current_exception());
+                }
+            }
+            // Notified under the lock: once the destructor's wait_all() sees every slot idle, this
+            // callback no longer touches any member
+            std::lock_guard<std::mutex> lock(slots_mutex_);
+            idle_slots_.push_back(i);
+            slots_cv_.notify_all();
+        });
+        async_slots_.push_back(std::move(slot));
+        idle_slots_.push_back(i);
+    }
+}
+
+void OVInfer::validate_input_bytes(const cv::Mat& input_blob) const
+{
+    // The input_blob is already in the tensor format the compiled model expects:
+    // f32 NCHW blob by default, u8 NHWC image when preprocessing is embedded
+    const size_t expected_bytes = compiled_model_.input().get_element_type().size() * ov::shape_size(compiled_model_.input().get_shape());
+    if (!input_blob.isContinuous() || input_blob.total() * input_blob.elemSize() != expected_bytes) {
+        throw InferenceExecutionException("OVInfer input has " + std::to_string(input_blob.total() * input_blob.elemSize()) +
+            " bytes, compiled model expects " + std::to_string(expected_bytes));
+    }
+}
+
+std::future<std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>> OVInfer::submit(const cv::Mat& input_blob)
+{
+    validate_input_bytes(input_blob);
+
+    size_t index;
+    {
+        std::unique_lock<std::mutex> lock(slots_mutex_);
+        slots_cv_.wait(lock, [this] { return !idle_slots_.empty(); });
+        index = idle_slots_.back();
+        idle_slots_.pop_back();
+    }
+
+    AsyncSlot& slot = *async_slots_[index];
+    slot.promise = std::promise<std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>>();
+    auto result = slot.promise.get_future();
+
+    ov::Tensor input_tensor = slot.request.get_input_tensor();
+    std::memcpy(input_tensor.data(), input_blob.data, input_tensor.get_byte_size());
+    slot.request.start_async();
+
+    return result;
+}
+
+void OVInfer::wait_all()
+{
+    std::unique_lock<std::mutex> lock(slots_mutex_);
+    slots_cv_.wait(lock, [this] { return idle_slots_.size() == async_slots_.size(); });
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> OVInfer::get_infer_results(const cv::Mat& input_blob) 
+{
+    validate_input_bytes(input_blob);
           
     ov::Tensor input_tensor(compiled_model_.input().get_element_type(), compiled_model_.input().get_shape(), input_blob.data);
     // Set input tensor for model with one input
     infer_request_.set_input_tensor(input_tensor);    
     infer_request_.infer();  // Perform inference
 
-    // Get output tensor
-    auto output_tensor = infer_request_.get_output_tensor();
-    const float *output_buffer = output_tensor.data<const float>();  // Get pointer to output buffer
-    std::size_t output_size = output_tensor.get_size();  // Get the total size of the output tensor
-
-    // Extract the shape of the output tensor
-    std::vector<int64_t> output_shape(output_tensor.get_shape().begin(), 
-                                      output_tensor.get_shape().end());
+    return extract_outputs(infer_request_);
+}
 
-    // Extract the data and store it as TensorElement (std::variant)
-    std::vector<TensorElement> output;
-    for (std::size_t i = 0; i < output_size; ++i) {
-        output.push_back(static_cast<float>(output_buffer[i]));  // Wrap each float in TensorElement
+std::vector<ov::Tensor> OVInfer::get_output_tensors()
+{
+    std::vector<ov::Tensor> tensors;
+    for (size_t i = 0; i < compiled_model_.outputs().size(); ++i) {
+        tensors.push_back(infer_request_.get_output_tensor(i));
     }
+    return tensors;
+}
+
+// Bulk copy of a tensor into TensorElement, widening to the closest variant alternative
+template <typename T, typename Element>
+static std::vector<TensorElement> copy_tensor_data(const ov::Tensor& tensor)
+{
+    const T* data = tensor.data<const T>();
+    const size_t size = tensor.get_size();
+    std::vector<TensorElement> output(size);
+    std::transform(data, data + size, output.begin(), [](const T& value) {
+        return TensorElement{static_cast<Element>(value)};
+    });
+    return output;
+}
 
-    // Store the output and shape
-    outputs.emplace_back(output);
-    shapes.emplace_back(output_shape);
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> OVInfer::extract_outputs(ov::InferRequest& request)
+{
+    std::vector<std::vector<TensorElement>> outputs;
+    std::vector<std::vector<int64_t>> shapes;
+
+    // Every model output, in the order reported by get_model_info()
+    const size_t num_outputs = compiled_model_.outputs().size();
+    outputs.reserve(num_outputs);
+    shapes.reserve(num_outputs);
+
+    for (size_t i = 0; i < num_outputs; ++i) {
+        const ov::Tensor output_tensor = request.get_output_tensor(i);
+
+        switch (output_tensor.get_element_type()) {
+            case ov::element::f32:
+                outputs.emplace_back(copy_tensor_data<float, float>(output_tensor));
+                break;
+            case ov::element::f16:
+                outputs.emplace_back(copy_tensor_data<ov::float16, float>(output_tensor));
+                break;
+            case ov::element::bf16:
+                outputs.emplace_back(copy_tensor_data<ov::bfloat16, float>(output_tensor));
+                break;
+            case ov::element::f64:
+                outputs.emplace_back(copy_tensor_data<double, float>(output_tensor));
+                break;
+            case ov::element::i32:
+                outputs.emplace_back(copy_tensor_data<int32_t, int32_t>(output_tensor));
+                break;
+            case ov::element::i64:
+                outputs.emplace_back(copy_tensor_data<int64_t, int64_t>(output_tensor));
+                break;
+            case ov::element::u8:
+                outputs.emplace_back(copy_tensor_data<uint8_t, int32_t>(output_tensor));
+                break;
+            case ov::element::i8:
+                outputs.emplace_back(copy_tensor_data<int8_t, int32_t>(output_tensor));
+                break;
+            default:
+                throw InferenceExecutionException("Unsupported OpenVINO output element type: " +
+                    output_tensor.get_element_type().get_type_name());
+        }
+
+        const ov::Shape& output_shape = output_tensor.get_shape();
+        shapes.emplace_back(output_shape.begin(), output_shape.end());
+    }
 
-    return std::make_tuple(outputs, shapes);  // Return tuple of outputs and shapes
+    return std::make_tuple(outputs, shapes);
 }
\ No newline at end of file
@@ -1,12 +1,39 @@
 #pragma once
 #include "InferenceInterface.hpp"
+#include "OVContext.hpp"
 #include "openvino/runtime/core.hpp"
 #include "openvino/core/shape.hpp"
 #include "openvino/core/type/element_type.hpp"
+#include "openvino/core/preprocess/pre_post_process.hpp"
 #include <sstream>
+#include <future>
+#include <mutex>
+#include <condition_variable>
 
+// Preprocessing folded into the compiled graph: the first input then accepts u8 NHWC BGR images
+// (a continuous CV_8UC3 cv::Mat at network resolution) and OpenVINO performs the element type
+// conversion, color conversion, mean/scale and layout change with its own kernels.
+struct OVPreprocessOptions {
+    bool enabled = false;
+    bool bgr_to_rgb = true;
+    std::vector<float> mean;    // Per channel, subtracted after conversion to f32
+    std::vector<float> scale;   // Per channel, divides the mean-subtracted values
+    std::string model_layout = "NCHW";
+};
 
-
+struct OVOptions {
+    OVPreprocessOptions preprocess;
+    // Compile with the THROUGHPUT performance hint so the CPU plugin runs several streams in parallel;
+    // submit() then keeps one infer request per stream busy
+    bool throughput_mode = false;
+    // Per-model budget on the shared CPU executor: streams and threads this compiled model may use.
+    // A budget (num_threads, or num_streams threads) is booked on OVContext and clamped to the threads
+    // other models left; construction throws when none are left. 0 for both leaves the choice to the
+    // plugin (ov::streams::AUTO in throughput mode) and books nothing.
+    int num_streams = 0;
+    int num_threads = 0;
+    size_t num_requests = 0;    // Size of the async request pool, 0 uses ov::optimal_number_of_infer_requests
+};
 
 class OVInfer : public InferenceInterface
 {
@@ -14,18 +41,53 @@ public:
     OVInfer(const std::string& model_path, 
         bool use_gpu = false, 
         size_t batch_size = 1, 
-        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>());
+        const std::vector<std::vector<int64_t>>& input_sizes = std::vector<std::vector<int64_t>>(),
+        const OVOptions& options = OVOptions());
+
+    ~OVInfer();
 
     std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
 
+    // Asynchronous inference on the request pool. The input is copied into an idle request,
+    // so the caller may release it as soon as submit() returns. Blocks while every request is busy.
+    std::future<std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>> submit(const cv::Mat& input_blob);
+
+    // Blocks until every submitted request has completed
+    void wait_all();
+
+    size_t get_num_requests() const noexcept { return async_slots_.size(); }
+    // CPU threads booked on the shared executor, 0 without a budget
+    int get_reserved_threads() const noexcept { return reserved_threads_; }
+
+    // Zero-copy views of the outputs of the last get_infer_results() call, in native element types.
+    // Valid until the next synchronous inference.
+    std::vector<ov::Tensor> get_output_tensors();
+
 private:  
      // Helper function to print ov::Shape and ov::PartialShape
     template <typename ShapeType>
     std::string print_shape(const ShapeType& shape);
+
+    void apply_preprocessing();
+    void create_request_pool();
+    void validate_input_bytes(const cv::Mat& input_blob) const;
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> extract_outputs(ov::InferRequest& request);
+
+    struct AsyncSlot {
+        ov::InferRequest request;
+        std::promise<std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>> promise;
+    };
     
-    ov::Core core_;
+    OVOptions options_;
+    std::shared_ptr<OVContext> context_;
+    int reserved_threads_ = 0;
     ov::Tensor input_tensor_;
     ov::InferRequest infer_request_;
     std::shared_ptr<ov::Model> model_;
     ov::CompiledModel compiled_model_;
+
+    std::vector<std::unique_ptr<AsyncSlot>> async_slots_;
+    std::vector<size_t> idle_slots_;
+    std::mutex slots_mutex_;
+    std::condition_variable slots_cv_;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "OVInfer.hpp"
+#include "StreamScheduler.hpp"
 #include <glog/logging.h>
 #include <opencv2/opencv.hpp>
 #include <cstdlib>
@@ -180,6 +181,172 @@ TEST_F(OpenVINOInferTest, DynamicShapes) {
     ASSERT_FALSE(output_vectors.empty());
 }
 
+// Test u8 NHWC BGR input with preprocessing folded into the graph
+TEST_F(OpenVINOInferTest, EmbeddedPreprocessing) {
+    OVOptions options;
+    options.preprocess.enabled = true;
+    options.preprocess.scale = {255.f, 255.f, 255.f};
+    OVInfer ppp_infer(model_path, false, 1, {}, options);
+    OVInfer float_infer(model_path, false);
+
+    cv::Mat image(224, 224, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    // Reference path: float NCHW RGB blob built on the CPU
+    cv::Mat blob;
+    cv::dnn::blobFromImage(image, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+    auto [float_outputs, float_shapes] = float_infer.get_infer_results(blob);
+
+    // The raw image goes straight in
+    auto [ppp_outputs, ppp_shapes] = ppp_infer.get_infer_results(image);
+
+    ASSERT_EQ(float_shapes, ppp_shapes);
+    ASSERT_EQ(float_outputs[0].size(), ppp_outputs[0].size());
+    for (size_t i = 0; i < float_outputs[0].size(); ++i) {
+        ASSERT_NEAR(std::get<float>(float_outputs[0][i]), std::get<float>(ppp_outputs[0][i]), 1e-2f);
+    }
+
+    // Network geometry is still reported channel-first, the tensor is declared as u8 NHWC
+    auto inputs = ppp_infer.get_model_info().getInputs();
+    ASSERT_EQ(inputs[0].shape[0], 3);
+    ASSERT_EQ(inputs[0].layout, TensorLayout::NHWC);
+    ASSERT_EQ(inputs[0].element_type, TensorElementType::U8);
+
+    // Blobs built for the engine are the raw image, whatever normalization the caller asks for
+    auto [blob_outputs, blob_shapes] = ppp_infer.get_infer_results(ppp_infer.blob_from_image(image, 1.f / 255.f, cv::Size(), cv::Scalar(), true));
+    ASSERT_EQ(blob_outputs[0].size(), ppp_outputs[0].size());
+    for (size_t i = 0; i < ppp_outputs[0].size(); ++i) {
+        ASSERT_NEAR(std::get<float>(blob_outputs[0][i]), std::get<float>(ppp_outputs[0][i]), 1e-4f);
+    }
+
+    // The stream scheduler stacks the same u8 samples
+    int frames = 0;
+    VideoSourceOptions source_options;
+    source_options.overflow = OverflowPolicy::Block;
+    VideoSource source([&image, &frames](cv::Mat& frame) {
+        if (frames == 2) {
+            return false;
+        }
+        ++frames;
+        image.copyTo(frame);
+        return true;
+    }, source_options);
+    std::vector<StreamOutput> delivered;
+    StreamScheduler scheduler(ppp_infer,
+        [](const cv::Mat& frame) { return frame; },
+        [&delivered](const StreamOutput& output) { delivered.push_back(output); });
+    scheduler.add_stream(source);
+    scheduler.run();
+    ASSERT_EQ(delivered.size(), 2u);
+    for (const auto& output : delivered) {
+        const auto& scheduled = std::get<0>(output.outputs);
+        ASSERT_EQ(scheduled[0].size(), ppp_outputs[0].size());
+        for (size_t i = 0; i < ppp_outputs[0].size(); ++i) {
+            ASSERT_NEAR(std::get<float>(scheduled[0][i]), std::get<float>(ppp_outputs[0][i]), 1e-4f);
+        }
+    }
+    EXPECT_EQ(scheduler.stats().streams[0].failed, 0u);
+
+    // A float blob no longer matches the compiled input
+    ASSERT_THROW(ppp_infer.get_infer_results(blob), InferenceExecutionException);
+}
+
+// Test throughput mode with the async request pool
+TEST_F(OpenVINOInferTest, ThroughputModeAsync) {
+    OVOptions options;
+    options.throughput_mode = true;
+    OVInfer infer(model_path, false, 1, {}, options);
+    ASSERT_GE(infer.get_num_requests(), 1u);
+
+    cv::Mat input = cv::Mat::zeros(224, 224, CV_8UC3);
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+    auto [sync_outputs, sync_shapes] = infer.get_infer_results(blob);
+
+    // Submit more requests than the pool holds so submit() has to wait for idle requests
+    const size_t num_submissions = infer.get_num_requests() * 2 + 1;
+    std::vector<std::future<std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>>> futures;
+    for (size_t i = 0; i < num_submissions; ++i) {
+        futures.push_back(infer.submit(blob));
+    }
+
+    for (auto& future : futures) {
+        auto [outputs, shapes] = future.get();
+        ASSERT_EQ(shapes, sync_shapes);
+        ASSERT_EQ(outputs[0].size(), sync_outputs[0].size());
+        ASSERT_NEAR(std::get<float>(outputs[0][0]), std::get<float>(sync_outputs[0][0]), 1e-4f);
+    }
+    infer.wait_all();
+}
+
+// Test that every model output is returned with its native element type
+TEST_F(OpenVINOInferTest, AllOutputsExtracted) {
+    OVInfer infer(model_path, false);
+
+    cv::Mat input = cv::Mat::zeros(224, 224, CV_8UC3);
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+    auto [output_vectors, shape_vectors] = infer.get_infer_results(blob);
+
+    auto output_infos = infer.get_model_info().getOutputs();
+    auto output_tensors = infer.get_output_tensors();
+    ASSERT_EQ(output_vectors.size(), output_infos.size());
+    ASSERT_EQ(output_tensors.size(), output_infos.size());
+
+    for (size_t i = 0; i < output_tensors.size(); ++i) {
+        ASSERT_EQ(output_vectors[i].size(), output_tensors[i].get_size());
+        if (output_tensors[i].get_element_type() == ov::element::f32) {
+            // Zero-copy view and bulk copy agree
+            const float* data = output_tensors[i].data<const float>();
+            ASSERT_FLOAT_EQ(std::get<float>(output_vectors[i][0]), data[0]);
+        }
+    }
+}
+
+// Test several models on the shared Core with per-model stream/thread budgets
+TEST_F(OpenVINOInferTest, SharedCoreBudgets) {
+    OVOptions options;
+    options.num_streams = 1;
+    options.num_threads = 1;
+    OVInfer first(model_path, false, 1, {}, options);
+    OVInfer second(model_path, false, 1, {}, options);
+
+    cv::Mat input = cv::Mat::zeros(224, 224, CV_8UC3);
+    cv::Mat blob;
+    cv::dnn::blobFromImage(input, blob, 1.f / 255.f, cv::Size(224, 224), cv::Scalar(), true, false);
+
+    auto [first_outputs, first_shapes] = first.get_infer_results(blob);
+    auto [second_outputs, second_shapes] = second.get_infer_results(blob);
+    ASSERT_EQ(first_shapes, second_shapes);
+    ASSERT_FLOAT_EQ(std::get<float>(first_outputs[0][0]), std::get<float>(second_outputs[0][0]));
+}
+
+// Test that budgets never add up to more threads than the shared executor has
+TEST_F(OpenVINOInferTest, SharedCoreBudgetEnforced) {
+    OVContextOptions context_options;
+    context_options.inference_num_threads = 3;
+    OVContext::configure(context_options);
+    {
+        OVOptions options;
+        options.num_threads = 2;
+        OVInfer first(model_path, false, 1, {}, options);
+        EXPECT_EQ(first.get_reserved_threads(), 2);
+
+        // Clamped to the one thread left
+        OVInfer second(model_path, false, 1, {}, options);
+        EXPECT_EQ(second.get_reserved_threads(), 1);
+        EXPECT_EQ(OVContext::instance()->reserved_threads(), 3);
+
+        EXPECT_THROW(OVInfer(model_path, false, 1, {}, options), ModelLoadException);
+        EXPECT_EQ(OVContext::instance()->reserved_threads(), 3);
+
+        // Unbudgeted models book nothing
+        OVInfer unbudgeted(model_path, false);
+        EXPECT_EQ(unbudgeted.get_reserved_threads(), 0);
+    }
+    OVContext::configure(OVContextOptions());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,76 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+// XXH64: fast non-cryptographic 64-bit hash, used to recognise byte-identical input tensors
+inline uint64_t xxh64(const void* data, size_t length, uint64_t seed = 0)
+{
+    constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+    constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+    constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+    const auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    const auto mix = [&rotl](uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; };
+    const auto read64 = [](const uint8_t* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+    const auto read32 = [](const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + length;
+    uint64_t h;
+    if (length >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = mix(v1, read64(p));
+            v2 = mix(v2, read64(p + 8));
+            v3 = mix(v3, read64(p + 16));
+            v4 = mix(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        for (uint64_t v : {v1, v2, v3, v4}) {
+            h = (h ^ mix(0, v)) * P1 + P4;
+        }
+    } else {
+        h = seed + P5;
+    }
+    h += length;
+
+    for (; p + 8 <= end; p += 8) {
+        h = rotl(h ^ mix(0, read64(p)), 27) * P1 + P4;
+    }
+    if (p + 4 <= end) {
+        h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h = rotl(h ^ (*p * P5), 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Hash of a blob's type, shape and bytes: equal for byte-identical tensors of the same shape
+inline uint64_t hash_blob(const cv::Mat& blob)
+{
+    int header[CV_MAX_DIM + 2] = {blob.type(), blob.dims};
+    for (int i = 0; i < blob.dims; ++i) {
+        header[i + 2] = blob.size[i];
+    }
+    const uint64_t seed = xxh64(header, sizeof(int) * (blob.dims + 2));
+    if (blob.empty()) {
+        return seed;
+    }
+    if (blob.isContinuous()) {
+        return xxh64(blob.data, blob.total() * blob.elemSize(), seed);
+    }
+    const cv::Mat continuous = blob.clone();
+    return xxh64(continuous.data, continuous.total() * continuous.elemSize(), seed);
+}
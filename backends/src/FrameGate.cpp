@@ -0,0 +1,61 @@
+#include "FrameGate.hpp"
+
+FrameGate::FrameGate(const FrameGateOptions& options)
+    : options_(options)
+{
+    if (options_.thumbnail.area() <= 0) {
+        throw std::invalid_argument("FrameGate thumbnail size must be positive");
+    }
+}
+
+void FrameGate::make_thumbnail(const cv::Mat& frame, cv::Mat& thumbnail)
+{
+    const cv::Mat* source = &frame;
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame, gray_, cv::COLOR_BGR2GRAY);
+        source = &gray_;
+    } else if (frame.channels() == 4) {
+        cv::cvtColor(frame, gray_, cv::COLOR_BGRA2GRAY);
+        source = &gray_;
+    }
+    // Area averaging also filters out sensor noise
+    cv::resize(*source, resized_, options_.thumbnail, 0, 0, cv::INTER_AREA);
+    resized_.convertTo(thumbnail, CV_8U, frame.depth() == CV_32F || frame.depth() == CV_64F ? 255.0 : 1.0);
+}
+
+bool FrameGate::should_infer(const cv::Mat& frame)
+{
+    if (frame.empty()) {
+        throw std::invalid_argument("FrameGate received an empty frame");
+    }
+    stats_.frames++;
+    make_thumbnail(frame, pending_);
+
+    if (reference_.empty()) {
+        return true;
+    }
+    stats_.last_difference = cv::norm(pending_, reference_, cv::NORM_L1) / pending_.total();
+
+    const bool too_many = options_.max_skipped_frames > 0 && skipped_in_row_ >= options_.max_skipped_frames;
+    const bool too_old = options_.max_age.count() > 0 && std::chrono::steady_clock::now() - inferred_at_ >= options_.max_age;
+    if (stats_.last_difference >= options_.threshold || too_many || too_old) {
+        return true;
+    }
+    skipped_in_row_++;
+    stats_.skipped++;
+    return false;
+}
+
+void FrameGate::commit()
+{
+    std::swap(reference_, pending_);
+    skipped_in_row_ = 0;
+    inferred_at_ = std::chrono::steady_clock::now();
+    stats_.inferred++;
+}
+
+void FrameGate::reset()
+{
+    reference_.release();
+    skipped_in_row_ = 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include <chrono>
+
+struct FrameGateOptions {
+    // Frames are compared as grayscale thumbnails of this size
+    cv::Size thumbnail = cv::Size(64, 64);
+    // Mean absolute difference (gray levels, 0-255) from the last inferred frame below which a frame
+    // reuses the previous outputs
+    double threshold = 2.0;
+    // Staleness bounds of reused outputs, 0 disables: consecutive skipped frames, time since the
+    // last inference
+    int max_skipped_frames = 30;
+    std::chrono::milliseconds max_age = std::chrono::milliseconds(1000);
+};
+
+struct FrameGateStats {
+    uint64_t frames = 0;
+    uint64_t inferred = 0;
+    uint64_t skipped = 0;
+    double last_difference = 0.0;  // Of the last frame against the last inferred frame
+};
+
+// Motion gate for one video stream (fixed cameras): a frame only goes to inference when it differs
+// enough from the last inferred frame, measured as the SAD of downsampled grayscale thumbnails
+// (cv::norm, vectorized by OpenCV). Other frames reuse the previous outputs up to a staleness bound.
+// Frames are 8-bit, or float in [0, 1]. One gate per stream; not thread-safe.
+class FrameGate
+{
+public:
+    using Result = std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>;
+
+    explicit FrameGate(const FrameGateOptions& options = FrameGateOptions());
+
+    // Returns infer(frame) when the frame must be inferred, otherwise the previous outputs
+    template <typename Fn>
+    const Result& process(const cv::Mat& frame, Fn&& infer)
+    {
+        if (should_infer(frame)) {
+            result_ = infer(frame);
+            commit();
+        }
+        return result_;
+    }
+
+    // Lower level use: decides for the frame; after running inference call commit() so the frame
+    // becomes the reference the next ones are compared with
+    bool should_infer(const cv::Mat& frame);
+    void commit();
+
+    // Forgets the reference frame, the next frame is inferred
+    void reset();
+
+    FrameGateStats stats() const { return stats_; }
+
+private:
+    void make_thumbnail(const cv::Mat& frame, cv::Mat& thumbnail);
+
+    FrameGateOptions options_;
+    FrameGateStats stats_;
+    cv::Mat reference_;  // Thumbnail of the last inferred frame
+    cv::Mat pending_;    // Thumbnail of the frame under decision
+    cv::Mat gray_, resized_;
+    int skipped_in_row_ = 0;
+    std::chrono::steady_clock::time_point inferred_at_;
+    Result result_;
+};
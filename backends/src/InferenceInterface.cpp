@@ -14,18 +14,24 @@ InferenceInterface::InferenceInterface(const std::string& weights,
 }
 
 ModelInfo InferenceInterface::get_model_info() noexcept {
-    // OpenCV DNN module does not have a method to get input layer shapes and names 
-    if (model_info_.getInputs().empty() && model_info_.getOutputs().empty()) {
-        // Add default input and output info if not set
-        std::vector<int64_t> input_shape = {3, 224, 224}; // CHW format
-        model_info_.addInput("input", input_shape, 1);
-        
-        std::vector<int64_t> output_shape = {1000}; // Classification output
-        model_info_.addOutput("output", output_shape, 1);
-    }
+    // Only what the backend registered: no shapes are made up for a backend that registered none
     return model_info_;
 }
 
+cv::Mat InferenceInterface::blob_from_image(const cv::Mat& image, double scale, const cv::Size& size,
+    const cv::Scalar& mean, bool swap_rb)
+{
+    // Through get_model_info() so wrappers report the layout of the engine they forward to
+    const ModelInfo info = get_model_info();
+    const auto& inputs = info.getInputs();
+    const TensorLayout layout = inputs.empty() ? TensorLayout::NCHW : inputs[0].layout;
+    if (!inputs.empty() && inputs[0].element_type == TensorElementType::U8) {
+        // The backend normalizes raw images itself
+        return ::blob_from_image(image, layout, 1.0, size, cv::Scalar(), false, CV_8U);
+    }
+    return ::blob_from_image(image, layout, scale, size, mean, swap_rb);
+}
+
 void InferenceInterface::clear_cache() noexcept {
     // Default implementation - do nothing
     // Derived classes can override this if they need cache management
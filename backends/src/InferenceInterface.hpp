@@ -6,6 +6,7 @@
 using TensorElement = std::variant<float, int32_t, int64_t>;
 
 #include "ModelInfo.hpp"
+#include "TensorLayout.hpp"
 
 // Custom exceptions for better error handling
 class InferenceException : public std::runtime_error {
@@ -37,8 +38,15 @@ class InferenceInterface{
         virtual std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> 
         get_infer_results(const cv::Mat& input_blob) = 0;
         
-        // Model information
+        // Model information, as registered by the backend; empty if it registered nothing
         virtual ModelInfo get_model_info() noexcept;
+
+        // Input blob for the first model input, built straight from an HWC image in the layout
+        // the backend declared for it (as get_model_info() reports it, so wrappers such as
+        // CachedInference use their engine's layout), so no transpose is needed inside get_infer_results.
+        // A U8 input gets the resized raw image: scale, mean and swap_rb are left to the backend.
+        cv::Mat blob_from_image(const cv::Mat& image, double scale = 1.0, const cv::Size& size = cv::Size(),
+            const cv::Scalar& mean = cv::Scalar(), bool swap_rb = false);
         
         // Utility methods
         virtual bool is_gpu_available() const noexcept { return gpu_available_; }
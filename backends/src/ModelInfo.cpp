@@ -1,11 +1,12 @@
 #include  "ModelInfo.hpp"
 
-void ModelInfo::addInput(const std::string& name, const std::vector<int64_t>& shape, size_t batch_size) {
-    inputs.push_back({name, shape, batch_size});
+void ModelInfo::addInput(const std::string& name, const std::vector<int64_t>& shape, size_t batch_size, TensorLayout layout,
+    TensorElementType element_type) {
+    inputs.push_back({name, shape, batch_size, layout, element_type});
 }
 
 void ModelInfo::addOutput(const std::string& name, const std::vector<int64_t>& shape, size_t batch_size) {
-    outputs.push_back({name, shape, batch_size});
+    outputs.push_back({name, shape, batch_size, TensorLayout::NCHW});
 }   
 
 const std::vector<LayerInfo>& ModelInfo::getInputs() const {
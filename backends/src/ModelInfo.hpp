@@ -2,10 +2,25 @@
 #include <string>
 #include <vector>
 
+// Memory order a backend consumes for an input
+enum class TensorLayout {
+    NCHW,
+    NHWC
+};
+
+// Element type of an input. U8 inputs take the raw 8-bit image and the backend converts and
+// normalizes it itself (e.g. preprocessing folded into an OpenVINO graph).
+enum class TensorElementType {
+    F32,
+    U8
+};
+
 struct LayerInfo {
     std::string name;
-    std::vector<int64_t> shape;
+    std::vector<int64_t> shape;   // Image inputs are always reported channel-first, whatever the layout
     size_t batch_size;
+    TensorLayout layout = TensorLayout::NCHW;
+    TensorElementType element_type = TensorElementType::F32;
 };
 
 class ModelInfo {
@@ -14,8 +29,9 @@ private:
     std::vector<LayerInfo> outputs;
     
 public:
-    void addInput(const std::string& name, const std::vector<int64_t>& shape, size_t batch_size);
+    void addInput(const std::string& name, const std::vector<int64_t>& shape, size_t batch_size, TensorLayout layout = TensorLayout::NCHW,
+        TensorElementType element_type = TensorElementType::F32);
     void addOutput(const std::string& name, const std::vector<int64_t>& shape, size_t batch_size);
     const std::vector<LayerInfo>& getInputs() const;
     const std::vector<LayerInfo>& getOutputs() const;
-};
\ No newline at end of file
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Where a request goes when no replica is idle
+enum class ReplicaPolicy {
+    LeastLoaded,    // Queue on the replica with the fewest requests in flight
+    RoundRobin      // Queue on replicas in rotation
+};
+
+// N engines for the same model, for backends whose engine can't be shared between threads
+// (cv::dnn::Net, single infer request engines). Requests go to an idle replica popped from a
+// lock-free free-list; when every replica is busy the policy picks one to queue on.
+// Several single-threaded replicas often beat one engine with N intra-op threads on small models.
+template <typename Engine = InferenceInterface>
+class ReplicaPool
+{
+public:
+    // Builds replica replica_index, which should use at most num_threads threads. The count is only
+    // advisory: the factory has to pass it to a per-engine setting (ONNX Runtime intra-op threads,
+    // OVOptions::num_threads, ...). Backends whose thread pool is process-wide cannot isolate
+    // replicas: OCVDNNOptions::num_threads calls cv::setNumThreads and LibTorch's intra-op pool is
+    // global too, so their replicas share one pool, sized once for the process, whatever is passed here.
+    using Factory = std::function<std::unique_ptr<Engine>(size_t replica_index, int num_threads)>;
+
+    // num_threads_per_replica 0 splits the hardware threads evenly between the replicas
+    ReplicaPool(size_t num_replicas, const Factory& factory,
+        ReplicaPolicy policy = ReplicaPolicy::LeastLoaded, int num_threads_per_replica = 0)
+        : policy_(policy)
+    {
+        if (num_replicas == 0 || num_replicas >= kEmpty) {
+            throw std::invalid_argument("ReplicaPool needs between 1 and 2^32 - 2 replicas");
+        }
+        if (num_threads_per_replica <= 0) {
+            const size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+            num_threads_per_replica = static_cast<int>(std::max<size_t>(1, hardware_threads / num_replicas));
+        }
+
+        replicas_.reserve(num_replicas);
+        for (size_t i = 0; i < num_replicas; ++i) {
+            auto replica = std::make_unique<Replica>();
+            replica->engine = factory(i, num_threads_per_replica);
+            if (!replica->engine) {
+                throw ModelLoadException("ReplicaPool factory returned no engine for replica " + std::to_string(i));
+            }
+            replicas_.push_back(std::move(replica));
+        }
+        for (size_t i = num_replicas; i-- > 0;) {
+            push_idle(static_cast<uint32_t>(i));
+        }
+    }
+
+    ReplicaPool(const ReplicaPool&) = delete;
+    ReplicaPool& operator=(const ReplicaPool&) = delete;
+
+    // Thread-safe inference on one of the replicas
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob)
+    {
+        return run([&input_blob](Engine& engine) { return engine.get_infer_results(input_blob); });
+    }
+
+    // Runs fn with exclusive access to one replica, for engine specific calls
+    template <typename Fn>
+    auto run(Fn&& fn) -> decltype(fn(std::declval<Engine&>()))
+    {
+        uint32_t index;
+        if (!pop_idle(index)) {
+            index = pick_busy();
+        }
+        Replica& replica = *replicas_[index];
+        replica.load.fetch_add(1, std::memory_order_acq_rel);
+
+        struct Release {
+            ReplicaPool* pool;
+            uint32_t index;
+            ~Release() { pool->release(index); }
+        } release{this, index};
+
+        std::lock_guard<std::mutex> lock(replica.mutex);
+        return fn(*replica.engine);
+    }
+
+    size_t size() const noexcept { return replicas_.size(); }
+    Engine& replica(size_t index) { return *replicas_[index]->engine; }
+
+    // Requests running or queued on a replica
+    int get_load(size_t index) const noexcept { return replicas_[index]->load.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t kEmpty = 0xffffffffu;
+
+    struct Replica {
+        std::unique_ptr<Engine> engine;
+        std::mutex mutex;
+        std::atomic<int> load{0};
+        std::atomic<bool> listed{false};        // Currently on the free-list
+        std::atomic<uint32_t> next{kEmpty};     // Free-list link
+    };
+
+    // Free-list head: replica index in the low 32 bits, ABA tag in the high 32 bits
+    static uint64_t pack(uint32_t index, uint32_t tag) { return (static_cast<uint64_t>(tag) << 32) | index; }
+
+    bool pop_idle(uint32_t& index)
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (static_cast<uint32_t>(head) != kEmpty) {
+            const uint32_t top = static_cast<uint32_t>(head);
+            const uint64_t next = pack(replicas_[top]->next.load(std::memory_order_relaxed), static_cast<uint32_t>(head >> 32) + 1);
+            if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                replicas_[top]->listed.store(false, std::memory_order_release);
+                index = top;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void push_idle(uint32_t index)
+    {
+        // A replica is listed at most once, the link field would otherwise be overwritten
+        if (replicas_[index]->listed.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            replicas_[index]->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            next = pack(index, static_cast<uint32_t>(head >> 32) + 1);
+        } while (!head_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    uint32_t pick_busy()
+    {
+        if (policy_ == ReplicaPolicy::RoundRobin) {
+            return static_cast<uint32_t>(round_robin_.fetch_add(1, std::memory_order_relaxed) % replicas_.size());
+        }
+        uint32_t best = 0;
+        int best_load = replicas_[0]->load.load(std::memory_order_relaxed);
+        for (uint32_t i = 1; i < replicas_.size() && best_load > 0; ++i) {
+            const int load = replicas_[i]->load.load(std::memory_order_relaxed);
+            if (load < best_load) {
+                best = i;
+                best_load = load;
+            }
+        }
+        return best;
+    }
+
+    void release(uint32_t index)
+    {
+        if (replicas_[index]->load.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            push_idle(index);
+        }
+    }
+
+    ReplicaPolicy policy_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::atomic<uint64_t> head_{pack(kEmpty, 0)};
+    std::atomic<size_t> round_robin_{0};
+};
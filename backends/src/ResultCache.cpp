@@ -0,0 +1,170 @@
+#include "ResultCache.hpp"
+
+ResultCache::ResultCache(size_t max_bytes, std::chrono::milliseconds default_ttl)
+    : max_bytes_(max_bytes)
+    , default_ttl_(default_ttl)
+{
+}
+
+void ResultCache::set_ttl(const std::string& model, std::chrono::milliseconds ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttls_[model] = ttl;
+}
+
+std::chrono::milliseconds ResultCache::ttl_of(const std::string& model) const
+{
+    const auto it = ttls_.find(model);
+    return it == ttls_.end() ? default_ttl_ : it->second;
+}
+
+size_t ResultCache::entry_bytes(const Key& key, const Result& result)
+{
+    size_t bytes = sizeof(Entry) + key.model.size();
+    for (const auto& output : std::get<0>(result)) {
+        bytes += sizeof(output) + output.size() * sizeof(TensorElement);
+    }
+    for (const auto& shape : std::get<1>(result)) {
+        bytes += sizeof(shape) + shape.size() * sizeof(int64_t);
+    }
+    return bytes;
+}
+
+void ResultCache::erase(std::list<Entry>::iterator it)
+{
+    ResultCacheStats& stats = model_stats_[it->key.model];
+    stats.entries--;
+    stats.bytes -= it->bytes;
+    bytes_ -= it->bytes;
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+std::optional<ResultCache::Result> ResultCache::find(const std::string& model, uint64_t hash)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResultCacheStats& stats = model_stats_[model];
+    const auto it = index_.find(Key{model, hash});
+    if (it == index_.end()) {
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    const auto ttl = ttl_of(model);
+    if (ttl.count() > 0 && std::chrono::steady_clock::now() - it->second->inserted > ttl) {
+        erase(it->second);
+        stats.expirations++;
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    stats.hits++;
+    return it->second->result;
+}
+
+void ResultCache::insert(const std::string& model, uint64_t hash, const Result& result)
+{
+    Key key{model, hash};
+    const size_t bytes = entry_bytes(key, result);
+    if (bytes > max_bytes_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto existing = index_.find(key);
+    if (existing != index_.end()) {
+        erase(existing->second);
+    }
+    while (!lru_.empty() && bytes_ + bytes > max_bytes_) {
+        auto oldest = std::prev(lru_.end());
+        model_stats_[oldest->key.model].evictions++;
+        erase(oldest);
+    }
+
+    lru_.push_front(Entry{key, result, bytes, std::chrono::steady_clock::now()});
+    index_.emplace(std::move(key), lru_.begin());
+    ResultCacheStats& stats = model_stats_[model];
+    stats.entries++;
+    stats.bytes += bytes;
+    bytes_ += bytes;
+}
+
+void ResultCache::erase_model(const std::string& model)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        auto next = std::next(it);
+        if (it->key.model == model) {
+            erase(it);
+        }
+        it = next;
+    }
+}
+
+void ResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+    for (auto& [model, stats] : model_stats_) {
+        stats.entries = 0;
+        stats.bytes = 0;
+    }
+}
+
+ResultCacheStats ResultCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResultCacheStats total;
+    for (const auto& [model, stats] : model_stats_) {
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+        total.expirations += stats.expirations;
+        total.evictions += stats.evictions;
+        total.entries += stats.entries;
+        total.bytes += stats.bytes;
+    }
+    return total;
+}
+
+ResultCacheStats ResultCache::stats(const std::string& model) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = model_stats_.find(model);
+    return it == model_stats_.end() ? ResultCacheStats() : it->second;
+}
+
+CachedInference::CachedInference(std::unique_ptr<InferenceInterface> engine, std::shared_ptr<ResultCache> cache,
+    std::chrono::milliseconds ttl, const std::string& model_key)
+    : InferenceInterface{engine->get_model_path(), engine->is_gpu_available(), engine->get_batch_size()}
+    , engine_(std::move(engine))
+    , cache_(std::move(cache))
+    , model_key_(model_key.empty() ? engine_->get_model_path() : model_key)
+{
+    if (ttl.count() > 0) {
+        cache_->set_ttl(model_key_, ttl);
+    }
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>
+CachedInference::get_infer_results(const cv::Mat& input_blob)
+{
+    start_timer();
+    const uint64_t hash = hash_blob(input_blob);
+    if (auto cached = cache_->find(model_key_, hash)) {
+        end_timer();
+        return std::move(*cached);
+    }
+    auto result = engine_->get_infer_results(input_blob);
+    cache_->insert(model_key_, hash, result);
+    end_timer();
+    return result;
+}
+
+void CachedInference::clear_cache() noexcept
+{
+    cache_->erase_model(model_key_);
+    engine_->clear_cache();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include "ContentHash.hpp"
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t expirations = 0;   // Lookups that found an entry older than the model's TTL
+    uint64_t evictions = 0;     // Entries dropped to stay under the byte bound
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    double hit_rate() const { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses); }
+};
+
+// Thread-safe LRU of inference outputs keyed by model and input content hash, bounded by the
+// approximate bytes the outputs take. Several engines can share one cache, each under its own
+// model key with its own time-to-live.
+class ResultCache
+{
+public:
+    using Result = std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>;
+
+    // default_ttl 0 keeps entries until they are evicted
+    explicit ResultCache(size_t max_bytes = 64 * 1024 * 1024,
+        std::chrono::milliseconds default_ttl = std::chrono::milliseconds::zero());
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    void set_ttl(const std::string& model, std::chrono::milliseconds ttl);
+
+    std::optional<Result> find(const std::string& model, uint64_t hash);
+    void insert(const std::string& model, uint64_t hash, const Result& result);
+
+    void erase_model(const std::string& model);
+    void clear();
+
+    ResultCacheStats stats() const;
+    ResultCacheStats stats(const std::string& model) const;
+    size_t max_bytes() const noexcept { return max_bytes_; }
+
+private:
+    struct Key {
+        std::string model;
+        uint64_t hash;
+        bool operator==(const Key& other) const { return hash == other.hash && model == other.model; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.hash ^ std::hash<std::string>()(key.model); }
+    };
+    struct Entry {
+        Key key;
+        Result result;
+        size_t bytes;
+        std::chrono::steady_clock::time_point inserted;
+    };
+
+    static size_t entry_bytes(const Key& key, const Result& result);
+    std::chrono::milliseconds ttl_of(const std::string& model) const;
+    void erase(std::list<Entry>::iterator it);
+
+    const size_t max_bytes_;
+    const std::chrono::milliseconds default_ttl_;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // Most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    std::unordered_map<std::string, std::chrono::milliseconds> ttls_;
+    std::unordered_map<std::string, ResultCacheStats> model_stats_;
+    size_t bytes_ = 0;
+};
+
+// InferenceInterface in front of another engine that answers byte-identical inputs from a
+// ResultCache without running the backend. Only exact repeats hit: the key is a 64-bit hash of the
+// blob's type, shape and bytes.
+class CachedInference : public InferenceInterface
+{
+public:
+    // model_key defaults to the engine's model path; a nonzero ttl is set for that key
+    CachedInference(std::unique_ptr<InferenceInterface> engine, std::shared_ptr<ResultCache> cache,
+        std::chrono::milliseconds ttl = std::chrono::milliseconds::zero(), const std::string& model_key = std::string());
+
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
+
+    ModelInfo get_model_info() noexcept override { return engine_->get_model_info(); }
+    size_t get_memory_usage_mb() const noexcept override { return engine_->get_memory_usage_mb(); }
+    // Drops this model's cached outputs as well as the engine's caches
+    void clear_cache() noexcept override;
+
+    ResultCacheStats cache_stats() const { return cache_->stats(model_key_); }
+    InferenceInterface& engine() { return *engine_; }
+
+private:
+    std::unique_ptr<InferenceInterface> engine_;
+    std::shared_ptr<ResultCache> cache_;
+    std::string model_key_;
+};
@@ -0,0 +1,67 @@
+#include "SingleFlight.hpp"
+
+SingleFlight::Result SingleFlight::run(const std::string& model, uint64_t hash, const std::function<Result()>& compute)
+{
+    Key key{model, hash};
+    std::promise<Result> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto it = calls_.find(key);
+        if (it != calls_.end()) {
+            coalesced_++;
+            std::shared_future<Result> pending = it->second;
+            lock.unlock();
+            return pending.get();
+        }
+        calls_.emplace(key, promise.get_future().share());
+        executions_++;
+    }
+
+    // The key is released before waiters are woken, so a request arriving afterwards computes again
+    // rather than reading a result that may already be stale
+    try {
+        Result result = compute();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            calls_.erase(key);
+        }
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            calls_.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+SingleFlightStats SingleFlight::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    SingleFlightStats stats;
+    stats.executions = executions_;
+    stats.coalesced = coalesced_;
+    stats.in_flight = calls_.size();
+    return stats;
+}
+
+CoalescedInference::CoalescedInference(std::unique_ptr<InferenceInterface> engine, std::shared_ptr<SingleFlight> flight,
+    const std::string& model_key)
+    : InferenceInterface{engine->get_model_path(), engine->is_gpu_available(), engine->get_batch_size()}
+    , engine_(std::move(engine))
+    , flight_(std::move(flight))
+    , model_key_(model_key.empty() ? engine_->get_model_path() : model_key)
+{
+}
+
+std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>
+CoalescedInference::get_infer_results(const cv::Mat& input_blob)
+{
+    // No inference timer here: unlike the engines this wrapper is called from several threads
+    return flight_->run(model_key_, hash_blob(input_blob), [this, &input_blob]() {
+        std::lock_guard<std::mutex> lock(engine_mutex_);
+        return engine_->get_infer_results(input_blob);
+    });
+}
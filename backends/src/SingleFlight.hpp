@@ -0,0 +1,71 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include "ContentHash.hpp"
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+struct SingleFlightStats {
+    uint64_t executions = 0;  // Calls that ran the computation
+    uint64_t coalesced = 0;   // Calls that waited for an identical call in flight instead
+    size_t in_flight = 0;
+};
+
+// Coalesces concurrent identical requests: the first call for a (model, input hash) key runs the
+// computation, calls for the same key arriving before it finishes wait for it and all receive its
+// outputs, or its exception. Nothing is kept once the call completes, see ResultCache for that.
+class SingleFlight
+{
+public:
+    using Result = std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>;
+
+    SingleFlight() = default;
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    Result run(const std::string& model, uint64_t hash, const std::function<Result()>& compute);
+
+    SingleFlightStats stats() const;
+
+private:
+    struct Key {
+        std::string model;
+        uint64_t hash;
+        bool operator==(const Key& other) const { return hash == other.hash && model == other.model; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.hash ^ std::hash<std::string>()(key.model); }
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, std::shared_future<Result>, KeyHash> calls_;
+    uint64_t executions_ = 0;
+    uint64_t coalesced_ = 0;
+};
+
+// InferenceInterface in front of another engine that runs a forward pass once for identical blobs
+// requested at the same time. Engines are not thread-safe, so calls for distinct blobs still run one
+// at a time on the wrapped engine.
+class CoalescedInference : public InferenceInterface
+{
+public:
+    // model_key defaults to the engine's model path
+    CoalescedInference(std::unique_ptr<InferenceInterface> engine, std::shared_ptr<SingleFlight> flight = std::make_shared<SingleFlight>(),
+        const std::string& model_key = std::string());
+
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> get_infer_results(const cv::Mat& input_blob) override;
+
+    ModelInfo get_model_info() noexcept override { return engine_->get_model_info(); }
+    size_t get_memory_usage_mb() const noexcept override { return engine_->get_memory_usage_mb(); }
+    void clear_cache() noexcept override { engine_->clear_cache(); }
+
+    SingleFlightStats flight_stats() const { return flight_->stats(); }
+    InferenceInterface& engine() { return *engine_; }
+
+private:
+    std::unique_ptr<InferenceInterface> engine_;
+    std::shared_ptr<SingleFlight> flight_;
+    std::string model_key_;
+    std::mutex engine_mutex_;  // Serializes the calls for distinct keys
+};
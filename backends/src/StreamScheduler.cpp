@@ -0,0 +1,206 @@
+#include "StreamScheduler.hpp"
+#include <cstring>
+
+namespace {
+
+constexpr auto kPollInterval = std::chrono::microseconds(500);
+
+}  // namespace
+
+StreamScheduler::StreamScheduler(InferenceInterface& engine, Preprocess preprocess, Sink sink, const StreamSchedulerOptions& options)
+    : engine_(engine)
+    , preprocess_(std::move(preprocess))
+    , sink_(std::move(sink))
+    , options_(options)
+{
+    if (options_.max_in_flight == 0) {
+        throw std::invalid_argument("StreamScheduler max_in_flight must be positive");
+    }
+}
+
+size_t StreamScheduler::add_stream(VideoSource& source, double weight)
+{
+    if (weight <= 0.0) {
+        throw std::invalid_argument("Stream weight must be positive");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.push_back(Stream{&source, weight});
+    return streams_.size() - 1;
+}
+
+bool StreamScheduler::take(size_t index)
+{
+    Stream& stream = streams_[index];
+    if (stream.taken >= options_.max_in_flight) {
+        return false;
+    }
+    VideoFrame& frame = batch_[filled_].frame;
+    const bool ready = stream.source->overflow() == OverflowPolicy::Block
+        ? stream.source->next(frame, std::chrono::milliseconds(0))
+        : stream.source->latest(frame, std::chrono::milliseconds(0));
+    if (!ready) {
+        return false;
+    }
+    batch_[filled_].stream = index;
+    filled_++;
+    stream.taken++;
+
+    // Start-time fair queuing: a stream coming back from idle starts at the current virtual time
+    // instead of claiming the service it missed
+    const double start = std::max(stream.virtual_time, virtual_clock_);
+    virtual_clock_ = start;
+    stream.virtual_time = start + 1.0 / stream.weight;
+    return true;
+}
+
+void StreamScheduler::fill()
+{
+    if (options_.policy == BatchPolicy::RoundRobin) {
+        // Passes visiting every stream once, until the batch is full or a pass finds no frame
+        bool progress = true;
+        while (progress && filled_ < batch_.size()) {
+            progress = false;
+            for (size_t visited = 0; visited < streams_.size() && filled_ < batch_.size(); ++visited) {
+                const size_t index = cursor_;
+                cursor_ = (cursor_ + 1) % streams_.size();
+                progress |= take(index);
+            }
+        }
+        return;
+    }
+
+    // Least virtual time first, skipping streams without a frame ready
+    tried_.assign(streams_.size(), false);
+    while (filled_ < batch_.size()) {
+        size_t best = streams_.size();
+        for (size_t i = 0; i < streams_.size(); ++i) {
+            if (!tried_[i] && streams_[i].taken < options_.max_in_flight
+                && (best == streams_.size() || streams_[i].virtual_time < streams_[best].virtual_time)) {
+                best = i;
+            }
+        }
+        if (best == streams_.size()) {
+            break;
+        }
+        if (!take(best)) {
+            tried_[best] = true;
+        }
+    }
+}
+
+void StreamScheduler::infer()
+{
+    const size_t count = filled_;
+    const size_t padded = std::max(count, engine_batch_);
+    try {
+        size_t sample_bytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const cv::Mat sample = blob_from_image(preprocess_(batch_[i].frame.image), layout_,
+                1.0, cv::Size(), cv::Scalar(), false, depth_);
+            const size_t bytes = sample.total() * sample.elemSize();
+            if (i == 0) {
+                std::vector<int> sizes(sample.size.p, sample.size.p + sample.dims);
+                sizes[0] = static_cast<int>(padded);
+                blob_.create(static_cast<int>(sizes.size()), sizes.data(), sample.type());
+                sample_bytes = bytes;
+            } else if (bytes != sample_bytes) {
+                throw std::runtime_error("Preprocessed frames of one batch differ in size");
+            }
+            std::memcpy(blob_.data + i * sample_bytes, sample.data, sample_bytes);
+        }
+        std::memset(blob_.data + count * sample_bytes, 0, (padded - count) * sample_bytes);
+
+        const auto [outputs, shapes] = engine_.get_infer_results(blob_);
+        const auto done = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < count; ++i) {
+            StreamOutput output;
+            output.stream = batch_[i].stream;
+            output.index = batch_[i].frame.index;
+            output.captured = batch_[i].frame.captured;
+            auto& [frame_outputs, frame_shapes] = output.outputs;
+            for (size_t o = 0; o < outputs.size(); ++o) {
+                const auto& shape = shapes[o];
+                if (!shape.empty() && shape[0] == static_cast<int64_t>(padded) && outputs[o].size() % padded == 0) {
+                    const size_t per_frame = outputs[o].size() / padded;
+                    frame_outputs.emplace_back(outputs[o].begin() + i * per_frame, outputs[o].begin() + (i + 1) * per_frame);
+                    frame_shapes.push_back(shape);
+                    frame_shapes.back()[0] = 1;
+                } else {
+                    frame_outputs.push_back(outputs[o]);
+                    frame_shapes.push_back(shape);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Stream& stream = streams_[output.stream];
+                stream.stats.inferred++;
+                stream.total_latency_ms += std::chrono::duration<double, std::milli>(done - output.captured).count();
+                stream.stats.mean_latency_ms = stream.total_latency_ms / stream.stats.inferred;
+            }
+            // The frame is inferred whatever the sink does; its failure must not fail the batch
+            try {
+                sink_(output);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Sink failed on frame " << output.index << " of stream " << output.stream << ": " << e.what();
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "Inference on a batch of " << count << " frames failed: " << e.what();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            streams_[batch_[i].stream].stats.failed++;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        streams_[batch_[i].stream].taken = 0;
+    }
+    filled_ = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    batches_++;
+    frames_ += count;
+}
+
+void StreamScheduler::run()
+{
+    engine_batch_ = std::max<size_t>(engine_.get_batch_size(), 1);
+    const size_t max_batch = options_.max_batch > 0 ? options_.max_batch : engine_batch_;
+    batch_.resize(max_batch);
+    const ModelInfo info = engine_.get_model_info();
+    layout_ = info.getInputs().empty() ? TensorLayout::NCHW : info.getInputs()[0].layout;
+    depth_ = !info.getInputs().empty() && info.getInputs()[0].element_type == TensorElementType::U8 ? CV_8U : CV_32F;
+
+    while (!stopping_) {
+        fill();
+        if (filled_ == 0) {
+            if (std::all_of(streams_.begin(), streams_.end(), [](const Stream& stream) { return stream.source->finished(); })) {
+                break;
+            }
+            std::this_thread::sleep_for(kPollInterval);
+            continue;
+        }
+
+        // A partial batch waits a little for the other streams
+        const auto deadline = std::chrono::steady_clock::now() + options_.max_wait;
+        while (filled_ < max_batch && !stopping_ && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(kPollInterval);
+            fill();
+        }
+        infer();
+    }
+}
+
+StreamSchedulerStats StreamScheduler::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    StreamSchedulerStats stats;
+    stats.batches = batches_;
+    stats.frames = frames_;
+    for (const auto& stream : streams_) {
+        stats.streams.push_back(stream.stats);
+        stats.streams.back().dropped = stream.source->stats().dropped;
+    }
+    return stats;
+}
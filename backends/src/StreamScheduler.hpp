@@ -0,0 +1,105 @@
+#pragma once
+#include "VideoSource.hpp"
+
+enum class BatchPolicy {
+    RoundRobin,   // One frame per stream in turn
+    WeightedFair  // Streams served in proportion to their weight (least virtual time first)
+};
+
+struct StreamSchedulerOptions {
+    BatchPolicy policy = BatchPolicy::RoundRobin;
+    // Frames per forward pass, 0 uses the engine's batch size
+    size_t max_batch = 0;
+    // Frames of one stream taken and not yet delivered, i.e. at most this many per batch
+    size_t max_in_flight = 1;
+    // How long a partial batch waits for more frames after its first one
+    std::chrono::milliseconds max_wait = std::chrono::milliseconds(2);
+};
+
+struct StreamOutput {
+    size_t stream = 0;
+    uint64_t index = 0;                               // Frame position in its source
+    std::chrono::steady_clock::time_point captured;  // Frame decode time
+    std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>> outputs;
+};
+
+struct StreamStats {
+    uint64_t inferred = 0;
+    uint64_t failed = 0;
+    uint64_t dropped = 0;  // By the source, never inferred
+    double mean_latency_ms = 0.0;  // From decode to outputs
+};
+
+struct StreamSchedulerStats {
+    uint64_t batches = 0;
+    uint64_t frames = 0;
+    std::vector<StreamStats> streams;
+    double mean_batch_size() const { return batches > 0 ? static_cast<double>(frames) / batches : 0.0; }
+};
+
+// Batches frames from many video sources into one engine, on the calling thread. Each batch is built
+// from the frames ready at that moment, taken in round-robin or weighted-fair order so no stream
+// starves, stacked in the input layout and element type the engine declares (ModelInfo) and split back per frame:
+// outputs whose first dimension is the batch size are sliced, the others are given whole to every
+// frame. A partial batch is padded with zero samples up to the engine's batch size, so fixed-batch
+// engines take it too, and the padded outputs are dropped. Sources with the Block policy give their
+// frames in order, the others their latest frame.
+class StreamScheduler
+{
+public:
+    // Turns a frame into the image of one batch sample (HWC, resized), the same for all streams. Float
+    // for float engine inputs, 8-bit for U8 inputs, which the engine normalizes itself.
+    using Preprocess = std::function<cv::Mat(const cv::Mat&)>;
+    // Gets each inferred frame; an exception it throws is logged and only loses that frame's output
+    using Sink = std::function<void(const StreamOutput&)>;
+
+    StreamScheduler(InferenceInterface& engine, Preprocess preprocess, Sink sink,
+        const StreamSchedulerOptions& options = StreamSchedulerOptions());
+
+    // Before run(); the weight only matters for WeightedFair. Returns the stream id given to the sink
+    size_t add_stream(VideoSource& source, double weight = 1.0);
+
+    // Returns when every source has finished or stop() is called
+    void run();
+    void stop() { stopping_ = true; }
+
+    StreamSchedulerStats stats() const;
+
+private:
+    struct Stream {
+        VideoSource* source;
+        double weight;
+        double virtual_time = 0.0;
+        size_t taken = 0;  // In the batch being built
+        StreamStats stats;
+        double total_latency_ms = 0.0;
+    };
+    struct Pending {
+        size_t stream = 0;
+        VideoFrame frame;
+    };
+
+    bool take(size_t stream);
+    void fill();
+    void infer();
+
+    InferenceInterface& engine_;
+    Preprocess preprocess_;
+    Sink sink_;
+    StreamSchedulerOptions options_;
+    std::vector<Stream> streams_;
+    size_t cursor_ = 0;           // RoundRobin: next stream to visit
+    double virtual_clock_ = 0.0;  // WeightedFair: start tag of the last frame taken
+    std::vector<bool> tried_;
+    // Frames are taken into these slots, so their image buffers are recycled by the sources
+    std::vector<Pending> batch_;
+    size_t filled_ = 0;
+    TensorLayout layout_ = TensorLayout::NCHW;
+    int depth_ = CV_32F;
+    size_t engine_batch_ = 1;
+    cv::Mat blob_;  // Reused while the batch shape stays the same
+    std::atomic<bool> stopping_{false};
+    uint64_t batches_ = 0;
+    uint64_t frames_ = 0;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,117 @@
+#include "TensorLayout.hpp"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/dnn.hpp>
+#include <stdexcept>
+
+namespace {
+
+// Rows per parallel task: big enough to amortize the task overhead, small enough to stay in cache
+constexpr int kRowsPerStrip = 16;
+
+// Interleaves channel planes (each H x W) into an H x W x planes.size() buffer
+void interleave(const std::vector<const float*>& planes, float* dst, int h, int w)
+{
+    const int channels = static_cast<int>(planes.size());
+    const int strips = (h + kRowsPerStrip - 1) / kRowsPerStrip;
+    cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+        std::vector<cv::Mat> strip_planes(channels);
+        for (int strip = range.start; strip < range.end; ++strip) {
+            const int row = strip * kRowsPerStrip;
+            const int rows = std::min(kRowsPerStrip, h - row);
+            for (int ch = 0; ch < channels; ++ch) {
+                strip_planes[ch] = cv::Mat(rows, w, CV_32F, const_cast<float*>(planes[ch]) + static_cast<size_t>(row) * w);
+            }
+            cv::Mat strip_dst(rows, w, CV_32FC(channels), dst + static_cast<size_t>(row) * w * channels);
+            cv::merge(strip_planes, strip_dst);
+        }
+    });
+}
+
+// Splits an H x W x C interleaved buffer into C planes of H x W
+void deinterleave(const float* src, const std::vector<float*>& planes, int h, int w)
+{
+    const int channels = static_cast<int>(planes.size());
+    const int strips = (h + kRowsPerStrip - 1) / kRowsPerStrip;
+    cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+        std::vector<cv::Mat> strip_planes(channels);
+        for (int strip = range.start; strip < range.end; ++strip) {
+            const int row = strip * kRowsPerStrip;
+            const int rows = std::min(kRowsPerStrip, h - row);
+            for (int ch = 0; ch < channels; ++ch) {
+                strip_planes[ch] = cv::Mat(rows, w, CV_32F, planes[ch] + static_cast<size_t>(row) * w);
+            }
+            cv::Mat strip_src(rows, w, CV_32FC(channels), const_cast<float*>(src) + static_cast<size_t>(row) * w * channels);
+            cv::split(strip_src, strip_planes);
+        }
+    });
+}
+
+} // namespace
+
+void convert_layout(const float* src, float* dst, int n, int c, int h, int w, TensorLayout from, TensorLayout to)
+{
+    const size_t plane = static_cast<size_t>(h) * w;
+    if (from == to) {
+        std::copy(src, src + static_cast<size_t>(n) * c * plane, dst);
+        return;
+    }
+
+    if (from == TensorLayout::NCHW && to == TensorLayout::NHWC) {
+        for (int b = 0; b < n; ++b) {
+            std::vector<const float*> planes(c);
+            for (int ch = 0; ch < c; ++ch) {
+                planes[ch] = src + (static_cast<size_t>(b) * c + ch) * plane;
+            }
+            interleave(planes, dst + static_cast<size_t>(b) * c * plane, h, w);
+        }
+    } else if (from == TensorLayout::NHWC && to == TensorLayout::NCHW) {
+        for (int b = 0; b < n; ++b) {
+            std::vector<float*> planes(c);
+            for (int ch = 0; ch < c; ++ch) {
+                planes[ch] = dst + (static_cast<size_t>(b) * c + ch) * plane;
+            }
+            deinterleave(src + static_cast<size_t>(b) * c * plane, planes, h, w);
+        }
+    }
+}
+
+cv::Mat blob_from_image(const cv::Mat& image, TensorLayout layout, double scale,
+    const cv::Size& size, const cv::Scalar& mean, bool swap_rb, int depth)
+{
+    if (depth != CV_32F && depth != CV_8U) {
+        throw std::invalid_argument("Blobs are built as CV_32F or CV_8U");
+    }
+    if (depth == CV_8U && (scale != 1.0 || mean != cv::Scalar())) {
+        throw std::invalid_argument("Scale and mean are not supported for CV_8U blobs");
+    }
+    if (layout == TensorLayout::NCHW) {
+        return cv::dnn::blobFromImage(image, scale, size, mean, swap_rb, false, depth);
+    }
+
+    cv::Mat resized = image;
+    if (!size.empty() && size != image.size()) {
+        cv::resize(image, resized, size, 0, 0, cv::INTER_LINEAR);
+    }
+    if (swap_rb && resized.channels() == 3) {
+        cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
+    }
+
+    const int h = resized.rows;
+    const int w = resized.cols;
+    const int c = resized.channels();
+
+    // Convert straight into the blob memory, the HWC image already is NHWC with N = 1
+    const int nhwc_sizes[] = {1, h, w, c};
+    cv::Mat nhwc(4, nhwc_sizes, depth);
+    cv::Mat hwc(h, w, CV_MAKETYPE(depth, c), nhwc.data);
+    if (mean == cv::Scalar()) {
+        resized.convertTo(hwc, depth, scale);
+    } else {
+        resized.convertTo(hwc, CV_32F);
+        cv::subtract(hwc, mean, hwc);
+        if (scale != 1.0) {
+            hwc *= scale;
+        }
+    }
+    return nhwc;
+}
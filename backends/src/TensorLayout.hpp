@@ -0,0 +1,14 @@
+#pragma once
+#include "ModelInfo.hpp"
+#include <opencv2/core.hpp>
+
+// Builds a 4D blob in the requested layout straight from an HWC image (8-bit or float), with the
+// same resize/mean/scale/swap semantics as cv::dnn::blobFromImage: (image - mean) * scale.
+// NHWC needs no transpose at all since it is the image's own memory order. A CV_8U depth gives a
+// u8 NCHW or NHWC blob and, like blobFromImage, takes no mean and no scale.
+cv::Mat blob_from_image(const cv::Mat& image, TensorLayout layout, double scale = 1.0,
+    const cv::Size& size = cv::Size(), const cv::Scalar& mean = cv::Scalar(), bool swap_rb = false, int depth = CV_32F);
+
+// Converts a float tensor of logical shape N x C x H x W between layouts. The transpose works on
+// row strips with OpenCV's vectorized merge/split and runs the strips in parallel.
+void convert_layout(const float* src, float* dst, int n, int c, int h, int w, TensorLayout from, TensorLayout to);
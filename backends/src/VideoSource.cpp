@@ -0,0 +1,202 @@
+#include "VideoSource.hpp"
+#include <cctype>
+
+namespace {
+
+// Gives up an image buffer the decoder must not write into because someone else still reads it
+void recycle(cv::Mat& image)
+{
+    if (!image.u || image.u->refcount > 1) {
+        image.release();
+    }
+}
+
+}  // namespace
+
+VideoSource::Reader VideoSource::open_capture(const std::string& uri)
+{
+    auto capture = std::make_shared<cv::VideoCapture>();
+    const bool camera = !uri.empty() && std::all_of(uri.begin(), uri.end(), [](unsigned char c) { return std::isdigit(c); });
+    if (camera ? !capture->open(std::stoi(uri)) : !capture->open(uri)) {
+        throw std::runtime_error("Failed to open video source: " + uri);
+    }
+    return [capture](cv::Mat& image) { return capture->read(image); };
+}
+
+VideoSource::VideoSource(const std::string& uri, const VideoSourceOptions& options)
+    : VideoSource(open_capture(uri), options)
+{
+}
+
+VideoSource::VideoSource(Reader reader, const VideoSourceOptions& options)
+    : reader_(std::move(reader))
+    , overflow_(options.overflow)
+    , ring_(options.buffer_size)
+{
+    if (ring_.empty()) {
+        throw std::invalid_argument("VideoSource buffer size must be positive");
+    }
+    decoder_ = std::thread(&VideoSource::decode_loop, this);
+}
+
+VideoSource::~VideoSource()
+{
+    stop();
+}
+
+void VideoSource::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    not_full_.notify_all();
+    if (decoder_.joinable()) {
+        decoder_.join();
+    }
+}
+
+void VideoSource::decode_loop()
+{
+    cv::Mat image;
+    uint64_t index = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (overflow_ == OverflowPolicy::Block) {
+                not_full_.wait(lock, [this]() { return stopping_ || count_ < ring_.size(); });
+            }
+            if (stopping_) {
+                break;
+            }
+        }
+
+        bool read = false;
+        try {
+            read = reader_(image) && !image.empty();
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Video decoding failed: " << e.what();
+        }
+        const auto captured = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!read || stopping_) {
+            break;
+        }
+        stats_.decoded++;
+        const uint64_t position = index++;
+        if (count_ == ring_.size()) {
+            stats_.dropped++;
+            if (overflow_ == OverflowPolicy::DropNewest) {
+                continue;
+            }
+            // The oldest slot becomes the tail
+            head_ = (head_ + 1) % ring_.size();
+            count_--;
+        }
+        VideoFrame& slot = ring_[(head_ + count_) % ring_.size()];
+        std::swap(slot.image, image);
+        recycle(image);
+        slot.index = position;
+        slot.captured = captured;
+        count_++;
+        not_empty_.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ended_ = true;
+    not_empty_.notify_all();
+}
+
+bool VideoSource::take(VideoFrame& frame, std::chrono::milliseconds timeout, bool newest)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!not_empty_.wait_for(lock, timeout, [this]() { return count_ > 0 || ended_; }) || count_ == 0) {
+        return false;
+    }
+    if (newest && count_ > 1) {
+        stats_.dropped += count_ - 1;
+        head_ = (head_ + count_ - 1) % ring_.size();
+        count_ = 1;
+    }
+
+    VideoFrame& slot = ring_[head_];
+    recycle(frame.image);
+    std::swap(frame.image, slot.image);
+    frame.index = slot.index;
+    frame.captured = slot.captured;
+    head_ = (head_ + 1) % ring_.size();
+    count_--;
+    stats_.delivered++;
+    not_full_.notify_one();
+    return true;
+}
+
+bool VideoSource::latest(VideoFrame& frame, std::chrono::milliseconds timeout)
+{
+    return take(frame, timeout, true);
+}
+
+bool VideoSource::next(VideoFrame& frame, std::chrono::milliseconds timeout)
+{
+    return take(frame, timeout, false);
+}
+
+bool VideoSource::finished() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ended_ && count_ == 0;
+}
+
+VideoSourceStats VideoSource::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    VideoSourceStats stats = stats_;
+    stats.buffered = count_;
+    stats.finished = ended_ && count_ == 0;
+    return stats;
+}
+
+VideoPipeline::VideoPipeline(VideoSource& source, InferenceInterface& engine, Preprocess preprocess, Sink sink)
+    : source_(source)
+    , engine_(engine)
+    , preprocess_(std::move(preprocess))
+    , sink_(std::move(sink))
+{
+}
+
+void VideoPipeline::run(uint64_t max_frames)
+{
+    VideoFrame frame;
+    uint64_t inferred = 0;
+    while (!stopping_ && (max_frames == 0 || inferred < max_frames)) {
+        // Short waits so stop() is noticed on a stalled stream
+        if (!source_.latest(frame, std::chrono::milliseconds(100))) {
+            if (source_.finished()) {
+                break;
+            }
+            continue;
+        }
+
+        const Result result = engine_.get_infer_results(preprocess_(frame.image));
+        const double latency_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.captured).count();
+        inferred++;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.inferred++;
+            stats_.last_latency_ms = latency_ms;
+            stats_.max_latency_ms = std::max(stats_.max_latency_ms, latency_ms);
+            total_latency_ms_ += latency_ms;
+            stats_.mean_latency_ms = total_latency_ms_ / stats_.inferred;
+        }
+        sink_(frame, result);
+    }
+}
+
+VideoPipelineStats VideoPipeline::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    VideoPipelineStats stats = stats_;
+    stats.dropped = source_.stats().dropped;
+    return stats;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// What the decoder does with a new frame while the buffer is full
+enum class OverflowPolicy {
+    DropOldest,  // Live feeds: the buffer always holds the most recent frames
+    DropNewest,  // Keep the buffered frames, discard the new one
+    Block        // Wait for the consumer, nothing is dropped (files)
+};
+
+struct VideoSourceOptions {
+    size_t buffer_size = 4;
+    OverflowPolicy overflow = OverflowPolicy::DropOldest;
+};
+
+struct VideoFrame {
+    cv::Mat image;
+    uint64_t index = 0;                               // Position in decode order
+    std::chrono::steady_clock::time_point captured;  // When the decoder returned the frame
+};
+
+struct VideoSourceStats {
+    uint64_t decoded = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;  // By the overflow policy, or skipped by latest()
+    size_t buffered = 0;
+    bool finished = false;
+};
+
+// Decodes a video stream on its own thread into a fixed-size ring of frames. Image buffers circulate
+// between the decoder, the ring and the consumer's VideoFrame, so once every slot has been filled no
+// frame is allocated; a consumer image that is still shared elsewhere is not recycled.
+class VideoSource
+{
+public:
+    // Reads the next frame into the image, returns false at the end of the stream
+    using Reader = std::function<bool(cv::Mat&)>;
+
+    // uri is anything cv::VideoCapture opens: a file, an RTSP/HTTP URL, or a camera index
+    explicit VideoSource(const std::string& uri, const VideoSourceOptions& options = VideoSourceOptions());
+    explicit VideoSource(Reader reader, const VideoSourceOptions& options = VideoSourceOptions());
+    ~VideoSource();
+
+    VideoSource(const VideoSource&) = delete;
+    VideoSource& operator=(const VideoSource&) = delete;
+
+    // Newest buffered frame, the older buffered ones are dropped. Both return false when no frame
+    // arrives within the timeout or the stream has ended, see finished()
+    bool latest(VideoFrame& frame, std::chrono::milliseconds timeout);
+    // Oldest buffered frame
+    bool next(VideoFrame& frame, std::chrono::milliseconds timeout);
+
+    // Stops decoding, returns once the reader has returned
+    void stop();
+
+    // The stream has ended and every buffered frame has been taken
+    bool finished() const;
+    OverflowPolicy overflow() const { return overflow_; }
+    VideoSourceStats stats() const;
+
+private:
+    static Reader open_capture(const std::string& uri);
+    void decode_loop();
+    bool take(VideoFrame& frame, std::chrono::milliseconds timeout, bool newest);
+
+    Reader reader_;
+    OverflowPolicy overflow_;
+    std::vector<VideoFrame> ring_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    bool stopping_ = false;
+    bool ended_ = false;
+    VideoSourceStats stats_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::thread decoder_;
+};
+
+struct VideoPipelineStats {
+    uint64_t inferred = 0;
+    uint64_t dropped = 0;  // Frames of the source that were never inferred
+    // From decode to outputs
+    double last_latency_ms = 0.0;
+    double mean_latency_ms = 0.0;
+    double max_latency_ms = 0.0;
+};
+
+// Runs inference on the latest frame of a source, on the calling thread. Frames decoded meanwhile are
+// handled by the source's overflow policy, so with DropOldest the latency stays bounded by about one
+// inference instead of growing with a queue.
+class VideoPipeline
+{
+public:
+    using Result = std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>;
+    // Turns a frame into the engine's input blob
+    using Preprocess = std::function<cv::Mat(const cv::Mat&)>;
+    using Sink = std::function<void(const VideoFrame&, const Result&)>;
+
+    VideoPipeline(VideoSource& source, InferenceInterface& engine, Preprocess preprocess, Sink sink);
+
+    // Returns when the stream ends, stop() is called or max_frames were inferred (0 for no limit)
+    void run(uint64_t max_frames = 0);
+    void stop() { stopping_ = true; }
+
+    VideoPipelineStats stats() const;
+
+private:
+    VideoSource& source_;
+    InferenceInterface& engine_;
+    Preprocess preprocess_;
+    Sink sink_;
+    std::atomic<bool> stopping_{false};
+    double total_latency_ms_ = 0.0;
+    VideoPipelineStats stats_;
+    mutable std::mutex mutex_;
+};
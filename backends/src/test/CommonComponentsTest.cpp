@@ -0,0 +1,538 @@
+#include <gtest/gtest.h>
+#include "InferenceInterface.hpp"
+#include "ReplicaPool.hpp"
+#include "ResultCache.hpp"
+#include "SingleFlight.hpp"
+#include "FrameGate.hpp"
+#include "VideoSource.hpp"
+#include "StreamScheduler.hpp"
+#include "FakeEngine.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <thread>
+
+// Tests of the backend-independent components in backends/src, built for every DEFAULT_BACKEND
+
+// Layout conversions match the naive index mapping
+TEST(TensorLayoutTest, LayoutConversion) {
+    const int n = 2, c = 3, h = 37, w = 41;
+    std::vector<float> nchw(static_cast<size_t>(n) * c * h * w);
+    cv::randu(cv::Mat(1, static_cast<int>(nchw.size()), CV_32F, nchw.data()), -1.f, 1.f);
+
+    std::vector<float> nhwc(nchw.size());
+    convert_layout(nchw.data(), nhwc.data(), n, c, h, w, TensorLayout::NCHW, TensorLayout::NHWC);
+    for (int b = 0; b < n; ++b)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                for (int ch = 0; ch < c; ++ch)
+                    ASSERT_EQ(nhwc[((b * h + y) * w + x) * c + ch], nchw[((b * c + ch) * h + y) * w + x]);
+
+    std::vector<float> round_trip(nchw.size());
+    convert_layout(nhwc.data(), round_trip.data(), n, c, h, w, TensorLayout::NHWC, TensorLayout::NCHW);
+    ASSERT_EQ(round_trip, nchw);
+
+    // NHWC blob built straight from the image equals the transposed blobFromImage result
+    cv::Mat image(h, w, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::Mat nchw_blob = cv::dnn::blobFromImage(image, 1.f / 255.f, cv::Size(), cv::Scalar(), true, false);
+    cv::Mat nhwc_blob = blob_from_image(image, TensorLayout::NHWC, 1.f / 255.f, cv::Size(), cv::Scalar(), true);
+    ASSERT_EQ(nhwc_blob.size[3], 3);
+    std::vector<float> expected(static_cast<size_t>(h) * w * c);
+    convert_layout(nchw_blob.ptr<float>(), expected.data(), 1, c, h, w, TensorLayout::NCHW, TensorLayout::NHWC);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_NEAR(nhwc_blob.ptr<float>()[i], expected[i], 1e-6f);
+    }
+
+    // A u8 NHWC blob is the image bytes themselves
+    cv::Mat u8_blob = blob_from_image(image, TensorLayout::NHWC, 1.0, cv::Size(), cv::Scalar(), false, CV_8U);
+    ASSERT_EQ(u8_blob.depth(), CV_8U);
+    ASSERT_EQ(std::memcmp(u8_blob.data, image.data, image.total() * image.elemSize()), 0);
+}
+
+// The replica pool never runs two requests on one replica and spreads load over replicas
+TEST(ReplicaPoolTest, ExclusiveReplicas) {
+    for (auto policy : {ReplicaPolicy::LeastLoaded, ReplicaPolicy::RoundRobin}) {
+        ReplicaPool<FakeEngine> pool(3, [](size_t, int num_threads) {
+            EXPECT_GE(num_threads, 1);
+            auto engine = std::make_unique<FakeEngine>();
+            engine->delay = std::chrono::milliseconds(2);
+            return engine;
+        }, policy);
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 8; ++t) {
+            workers.emplace_back([&pool]() {
+                for (int i = 0; i < 20; ++i) {
+                    pool.get_infer_results(cv::Mat());
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        int total_calls = 0;
+        for (size_t r = 0; r < pool.size(); ++r) {
+            EXPECT_EQ(pool.replica(r).max_active, 1);
+            EXPECT_GT(pool.replica(r).calls, 0);
+            EXPECT_EQ(pool.get_load(r), 0);
+            total_calls += pool.replica(r).calls;
+        }
+        EXPECT_EQ(total_calls, 8 * 20);
+    }
+}
+
+// Repeats hit without running the engine, different inputs miss, entries
+// expire after the model's TTL and the byte bound evicts the least recently used entry
+TEST(ResultCacheTest, HitsExpiryAndEviction) {
+    auto cache = std::make_shared<ResultCache>(1 << 20);
+    auto owned = std::make_unique<FakeEngine>();
+    FakeEngine& engine = *owned;
+    CachedInference cached(std::move(owned), cache, std::chrono::milliseconds(50));
+
+    const cv::Mat ones(8, 8, CV_32F, cv::Scalar(1.f));
+    const cv::Mat twos(8, 8, CV_32F, cv::Scalar(2.f));
+    auto [first, first_shapes] = cached.get_infer_results(ones);
+    auto [repeat, repeat_shapes] = cached.get_infer_results(ones.clone());
+    EXPECT_EQ(engine.calls, 1);
+    EXPECT_EQ(std::get<float>(repeat[0][0]), 64.f);
+    EXPECT_EQ(repeat_shapes, first_shapes);
+    cached.get_infer_results(twos);
+    EXPECT_EQ(engine.calls, 2);
+    // Same bytes with another shape is another input
+    cached.get_infer_results(ones.reshape(1, 4));
+    EXPECT_EQ(engine.calls, 3);
+
+    ResultCacheStats stats = cached.cache_stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.entries, 3u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    cached.get_infer_results(ones);
+    EXPECT_EQ(engine.calls, 4);
+    EXPECT_EQ(cached.cache_stats().expirations, 1u);
+
+    // Room for two entries: touching the first makes the second the one evicted by a third
+    const ResultCache::Result result = std::make_tuple(std::vector<std::vector<TensorElement>>{{TensorElement(1.f)}},
+        std::vector<std::vector<int64_t>>{{1}});
+    ResultCache probe;
+    probe.insert("model", 1, result);
+    const size_t entry_bytes = probe.stats().bytes;
+    ResultCache small(2 * entry_bytes + entry_bytes / 2);
+    small.insert("model", 1, result);
+    small.insert("model", 2, result);
+    ASSERT_TRUE(small.find("model", 1).has_value());
+    small.insert("model", 3, result);
+    EXPECT_EQ(small.stats().evictions, 1u);
+    EXPECT_TRUE(small.find("model", 1).has_value());
+    EXPECT_FALSE(small.find("model", 2).has_value());
+    EXPECT_TRUE(small.find("model", 3).has_value());
+    EXPECT_FALSE(small.find("other", 3).has_value());
+
+    // Blobs built through the wrapper follow the wrapped engine's layout
+    auto nhwc_engine = std::make_unique<FakeEngine>();
+    nhwc_engine->model_info().addInput("input", {3, 6, 10}, 1, TensorLayout::NHWC);
+    CachedInference nhwc_cached(std::move(nhwc_engine), cache);
+    const cv::Mat blob = nhwc_cached.blob_from_image(cv::Mat(6, 10, CV_8UC3, cv::Scalar::all(1)));
+    ASSERT_EQ(blob.dims, 4);
+    EXPECT_EQ(blob.size[1], 6);
+    EXPECT_EQ(blob.size[3], 3);
+}
+
+// Identical concurrent requests share one forward pass and its
+// result, and an exception reaches every waiter
+TEST(SingleFlightTest, CoalescesIdenticalRequests) {
+    // The engine blocks until released, so every request arrives while the first is in flight
+    for (bool fail : {false, true}) {
+        std::promise<void> release;
+        auto owned = std::make_unique<FakeEngine>();
+        FakeEngine& engine = *owned;
+        engine.gate = release.get_future().share();
+        engine.fail = fail;
+        auto flight = std::make_shared<SingleFlight>();
+        CoalescedInference coalesced(std::move(owned), flight);
+
+        const cv::Mat ones(8, 8, CV_32F, cv::Scalar(1.f));
+        std::atomic<int> succeeded{0};
+        std::atomic<int> failed{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 6; ++t) {
+            workers.emplace_back([&]() {
+                try {
+                    auto [outputs, shapes] = coalesced.get_infer_results(ones.clone());
+                    if (std::get<float>(outputs[0][0]) == 64.f) {
+                        ++succeeded;
+                    }
+                } catch (const InferenceExecutionException&) {
+                    ++failed;
+                }
+            });
+        }
+        while (flight->stats().coalesced < 5) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        release.set_value();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        EXPECT_EQ(engine.calls, 1);
+        EXPECT_EQ(succeeded, fail ? 0 : 6);
+        EXPECT_EQ(failed, fail ? 6 : 0);
+        const SingleFlightStats stats = flight->stats();
+        EXPECT_EQ(stats.executions, 1u);
+        EXPECT_EQ(stats.coalesced, 5u);
+        EXPECT_EQ(stats.in_flight, 0u);
+    }
+}
+
+// Distinct inputs each run their own forward pass, one at a time on the wrapped engine
+TEST(SingleFlightTest, SerializesDistinctRequests) {
+    auto owned = std::make_unique<FakeEngine>();
+    FakeEngine& engine = *owned;
+    engine.delay = std::chrono::milliseconds(2);
+    CoalescedInference coalesced(std::move(owned));
+
+    std::atomic<int> correct{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 6; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < 10; ++i) {
+                const float value = static_cast<float>(t * 10 + i);
+                auto [outputs, shapes] = coalesced.get_infer_results(cv::Mat(4, 4, CV_32F, cv::Scalar(value)));
+                if (std::get<float>(outputs[0][0]) == 16.f * value) {
+                    ++correct;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(correct, 6 * 10);
+    EXPECT_EQ(engine.calls, 6 * 10);
+    EXPECT_EQ(engine.max_active, 1);
+    EXPECT_EQ(coalesced.flight_stats().executions, 60u);
+}
+
+// A static or noisy scene reuses the previous outputs, a changed scene and the
+// staleness bound trigger inference, and skipped frames are compared with the last inferred frame
+TEST(FrameGateTest, SkipsStaticFrames) {
+    FrameGateOptions options;
+    options.threshold = 4.0;
+    options.max_skipped_frames = 3;
+    options.max_age = std::chrono::milliseconds(0);
+    FrameGate gate(options);
+
+    int inferences = 0;
+    auto infer = [&inferences](const cv::Mat& frame) {
+        ++inferences;
+        std::vector<std::vector<TensorElement>> outputs{{TensorElement(static_cast<float>(cv::mean(frame)[0]))}};
+        std::vector<std::vector<int64_t>> shapes{{1}};
+        return std::make_tuple(outputs, shapes);
+    };
+
+    cv::Mat scene(480, 640, CV_8UC3, cv::Scalar(60, 60, 60));
+    cv::rectangle(scene, cv::Rect(100, 100, 200, 150), cv::Scalar(200, 200, 200), cv::FILLED);
+    gate.process(scene, infer);
+    EXPECT_EQ(inferences, 1);
+
+    // Pixel noise averages out in the thumbnail
+    cv::Mat noisy;
+    cv::Mat noise(scene.size(), CV_16SC3);
+    cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(3));
+    cv::add(scene, noise, noisy, cv::noArray(), CV_8U);
+    auto [outputs, shapes] = gate.process(noisy, infer);
+    EXPECT_EQ(inferences, 1);
+    EXPECT_FLOAT_EQ(std::get<float>(outputs[0][0]), static_cast<float>(cv::mean(scene)[0]));
+    EXPECT_LT(gate.stats().last_difference, options.threshold);
+
+    // An object moving in is inferred
+    cv::Mat moved = scene.clone();
+    cv::rectangle(moved, cv::Rect(350, 200, 200, 200), cv::Scalar(250, 250, 250), cv::FILLED);
+    gate.process(moved, infer);
+    EXPECT_EQ(inferences, 2);
+    EXPECT_GE(gate.stats().last_difference, options.threshold);
+
+    // Staleness bound: after max_skipped_frames reused outputs the next frame is inferred
+    for (int i = 0; i < options.max_skipped_frames; ++i) {
+        gate.process(moved, infer);
+    }
+    EXPECT_EQ(inferences, 2);
+    gate.process(moved, infer);
+    EXPECT_EQ(inferences, 3);
+
+    // Float frames in [0, 1] are gated alike
+    cv::Mat moved_float;
+    moved.convertTo(moved_float, CV_32F, 1.0 / 255);
+    gate.process(moved_float, infer);
+    EXPECT_EQ(inferences, 3);
+
+    gate.reset();
+    gate.process(moved, infer);
+    EXPECT_EQ(inferences, 4);
+
+    const FrameGateStats stats = gate.stats();
+    EXPECT_EQ(stats.frames, 9u);
+    EXPECT_EQ(stats.inferred, 4u);
+    EXPECT_EQ(stats.skipped, 5u);
+}
+
+// With a consumer that does not read, DropOldest keeps the newest frames, DropNewest the first
+// ones, and Block delivers every frame in order
+TEST(VideoSourceTest, OverflowPolicies) {
+    const int total = 10;
+    auto counting_reader = []() {
+        auto count = std::make_shared<int>(0);
+        return [count](cv::Mat& image) {
+            if (*count == total) {
+                return false;
+            }
+            image.create(48, 64, CV_8UC3);
+            image.setTo(cv::Scalar::all((*count)++));
+            return true;
+        };
+    };
+    auto wait_decoded = [](const VideoSource& source, uint64_t frames) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (source.stats().decoded < frames && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return source.stats().decoded;
+    };
+    auto drain = [](VideoSource& source) {
+        std::vector<int> values;
+        VideoFrame frame;
+        while (source.next(frame, std::chrono::milliseconds(1000))) {
+            EXPECT_EQ(static_cast<int>(frame.image.at<cv::Vec3b>(0, 0)[0]), static_cast<int>(frame.index));
+            values.push_back(static_cast<int>(frame.index));
+        }
+        return values;
+    };
+
+    for (auto policy : {OverflowPolicy::DropOldest, OverflowPolicy::DropNewest}) {
+        VideoSourceOptions options;
+        options.buffer_size = 4;
+        options.overflow = policy;
+        VideoSource source(counting_reader(), options);
+        ASSERT_EQ(wait_decoded(source, total), static_cast<uint64_t>(total));
+        const std::vector<int> expected = policy == OverflowPolicy::DropOldest ? std::vector<int>{6, 7, 8, 9} : std::vector<int>{0, 1, 2, 3};
+        EXPECT_EQ(drain(source), expected);
+        const VideoSourceStats stats = source.stats();
+        EXPECT_EQ(stats.dropped, 6u);
+        EXPECT_EQ(stats.delivered, 4u);
+        EXPECT_TRUE(stats.finished);
+    }
+
+    // The decoder fills the buffer, then waits for the consumer
+    VideoSourceOptions options;
+    options.buffer_size = 2;
+    options.overflow = OverflowPolicy::Block;
+    VideoSource blocking(counting_reader(), options);
+    ASSERT_EQ(wait_decoded(blocking, 2), 2u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(blocking.stats().decoded, 2u);
+    const std::vector<int> values = drain(blocking);
+    ASSERT_EQ(values.size(), static_cast<size_t>(total));
+    for (int i = 0; i < total; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(blocking.stats().dropped, 0u);
+}
+
+// Latest-frame inference on a feed faster than the engine: frames are dropped instead of queued and
+// outputs arrive in decode order. The engine holds its first inference until the whole stream has
+// been decoded, so the frames decoded meanwhile must be dropped whatever the timing.
+TEST(VideoSourceTest, PipelineDropsFramesBehindInference) {
+    const int total = 10;
+    auto count = std::make_shared<int>(0);
+    auto decoded_all = std::make_shared<std::promise<void>>();
+    FakeEngine engine([](const cv::Mat& blob) { return FakeEngine::make_result({blob.ptr<float>()[0]}, {1}); });
+    engine.gate = decoded_all->get_future().share();
+
+    VideoSource feed([count, decoded_all](cv::Mat& image) {
+        if (*count == total) {
+            decoded_all->set_value();
+            return false;
+        }
+        image.create(48, 64, CV_8UC3);
+        image.setTo(cv::Scalar::all((*count)++));
+        return true;
+    }, VideoSourceOptions());
+    std::vector<int> inferred;
+    VideoPipeline pipeline(feed, engine,
+        [](const cv::Mat& image) { return cv::dnn::blobFromImage(image); },
+        [&inferred](const VideoFrame& frame, const VideoPipeline::Result& result) {
+            EXPECT_EQ(static_cast<int>(std::get<float>(std::get<0>(result)[0][0])), static_cast<int>(frame.index));
+            inferred.push_back(static_cast<int>(frame.index));
+        });
+    pipeline.run();
+
+    // The first inference saw at most one frame; the latest one after it is the last frame
+    const VideoPipelineStats stats = pipeline.stats();
+    ASSERT_FALSE(inferred.empty());
+    EXPECT_LE(inferred.size(), 2u);
+    EXPECT_TRUE(std::is_sorted(inferred.begin(), inferred.end()));
+    EXPECT_EQ(inferred.back(), total - 1);
+    EXPECT_EQ(stats.inferred, inferred.size());
+    EXPECT_EQ(stats.inferred + stats.dropped, static_cast<uint64_t>(total));
+    EXPECT_GT(stats.dropped, 0u);
+    EXPECT_GT(stats.mean_latency_ms, 0.0);
+    EXPECT_LE(stats.mean_latency_ms, stats.max_latency_ms);
+}
+
+// Outputs are sliced per frame and routed to their stream, round-robin alternates streams,
+// weighted-fair serves them by weight, and max_in_flight caps a stream per batch
+TEST(StreamSchedulerTest, FairBatching) {
+    // Frames encode their stream in channel 1 and their index in channel 0
+    auto stream_reader = [](int stream, int frames) {
+        auto count = std::make_shared<int>(0);
+        return [count, stream, frames](cv::Mat& image) {
+            if (*count == frames) {
+                return false;
+            }
+            image.create(8, 8, CV_8UC3);
+            image.setTo(cv::Scalar((*count)++, stream, 0));
+            return true;
+        };
+    };
+    // Outputs (batch, 2) with the two encoded values of each sample, plus a batch-independent output
+    auto echo_engine = [](TensorLayout layout, std::vector<int>& batches) {
+        auto engine = std::make_unique<FakeEngine>([layout, &batches](const cv::Mat& blob) {
+            const int batch = blob.size[0];
+            const size_t channel_step = layout == TensorLayout::NHWC ? 1 : static_cast<size_t>(blob.size[2]) * blob.size[3];
+            batches.push_back(batch);
+            std::vector<float> values;
+            for (int b = 0; b < batch; ++b) {
+                const float* sample = blob.ptr<float>(b);
+                values.push_back(sample[0]);
+                values.push_back(sample[channel_step]);
+            }
+            FakeEngine::Result result = FakeEngine::make_result(values, {batch, 2});
+            std::get<0>(result).push_back({TensorElement(7.f)});
+            std::get<1>(result).push_back({1});
+            return result;
+        }, 4);
+        engine->model_info().addInput("input", {3, 8, 8}, 4, layout);
+        return engine;
+    };
+
+    const int frames = 12;
+    for (auto policy : {BatchPolicy::RoundRobin, BatchPolicy::WeightedFair}) {
+        // Block sources hold every frame, so each batch sees all streams ready
+        VideoSourceOptions source_options;
+        source_options.buffer_size = frames;
+        source_options.overflow = OverflowPolicy::Block;
+        VideoSource first(stream_reader(0, frames), source_options);
+        VideoSource second(stream_reader(1, frames), source_options);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while ((first.stats().decoded < static_cast<uint64_t>(frames) || second.stats().decoded < static_cast<uint64_t>(frames))
+            && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        StreamSchedulerOptions options;
+        options.policy = policy;
+        options.max_in_flight = 3;
+        std::vector<int> batches;
+        auto engine = echo_engine(TensorLayout::NCHW, batches);
+        std::vector<StreamOutput> delivered;
+        StreamScheduler scheduler(*engine,
+            [](const cv::Mat& image) { return image; },
+            [&delivered](const StreamOutput& output) { delivered.push_back(output); },
+            options);
+        ASSERT_EQ(scheduler.add_stream(first, 1.0), 0u);
+        ASSERT_EQ(scheduler.add_stream(second, 3.0), 1u);
+        scheduler.run();
+
+        ASSERT_EQ(delivered.size(), static_cast<size_t>(2 * frames));
+        std::vector<uint64_t> next_index(2, 0);
+        for (const auto& output : delivered) {
+            const auto& [outputs, shapes] = output.outputs;
+            ASSERT_EQ(shapes[0], (std::vector<int64_t>{1, 2}));
+            EXPECT_EQ(static_cast<uint64_t>(std::get<float>(outputs[0][0])), output.index);
+            EXPECT_EQ(static_cast<size_t>(std::get<float>(outputs[0][1])), output.stream);
+            EXPECT_FLOAT_EQ(std::get<float>(outputs[1][0]), 7.f);
+            EXPECT_GT(output.captured.time_since_epoch().count(), 0);
+            EXPECT_EQ(output.index, next_index[output.stream]++);
+        }
+
+        // Streams in the first batches: alternating, or one frame of the first stream for three of
+        // the second (weight 3, capped by max_in_flight)
+        ASSERT_GE(batches.size(), 2u);
+        for (size_t i = 0; i < 8; ++i) {
+            const size_t expected = policy == BatchPolicy::RoundRobin ? i % 2 : (i % 4 == 0 ? 0 : 1);
+            EXPECT_EQ(delivered[i].stream, expected);
+        }
+
+        // The engine always gets full batches
+        const StreamSchedulerStats stats = scheduler.stats();
+        EXPECT_EQ(stats.frames, static_cast<uint64_t>(2 * frames));
+        EXPECT_EQ(stats.batches, batches.size());
+        EXPECT_TRUE(std::all_of(batches.begin(), batches.end(), [](int batch) { return batch == 4; }));
+        EXPECT_GT(stats.mean_batch_size(), 1.0);
+        for (const auto& stream : stats.streams) {
+            EXPECT_EQ(stream.inferred, static_cast<uint64_t>(frames));
+            EXPECT_EQ(stream.failed, 0u);
+            EXPECT_EQ(stream.dropped, 0u);
+        }
+    }
+
+    // A partial batch for an NHWC engine: built in its layout, padded to its batch size, and only the
+    // real frames get outputs
+    VideoSourceOptions source_options;
+    source_options.buffer_size = 3;
+    source_options.overflow = OverflowPolicy::Block;
+    VideoSource single(stream_reader(1, 3), source_options);
+    StreamSchedulerOptions options;
+    options.max_in_flight = 3;
+    options.max_wait = std::chrono::milliseconds(50);
+    std::vector<int> batches;
+    auto engine = echo_engine(TensorLayout::NHWC, batches);
+    std::vector<StreamOutput> delivered;
+    StreamScheduler scheduler(*engine,
+        [](const cv::Mat& image) { return image; },
+        [&delivered](const StreamOutput& output) { delivered.push_back(output); },
+        options);
+    scheduler.add_stream(single);
+    scheduler.run();
+
+    ASSERT_EQ(delivered.size(), 3u);
+    for (const auto& output : delivered) {
+        const auto& [outputs, shapes] = output.outputs;
+        EXPECT_EQ(static_cast<uint64_t>(std::get<float>(outputs[0][0])), output.index);
+        EXPECT_FLOAT_EQ(std::get<float>(outputs[0][1]), 1.f);
+    }
+    EXPECT_TRUE(std::all_of(batches.begin(), batches.end(), [](int batch) { return batch == 4; }));
+    EXPECT_EQ(scheduler.stats().frames, 3u);
+
+    // A sink throwing on one frame neither fails the batch nor skips the frames after it
+    VideoSource throwing_source(stream_reader(0, 3), source_options);
+    std::vector<uint64_t> sunk;
+    StreamScheduler throwing(*engine,
+        [](const cv::Mat& image) { return image; },
+        [&sunk](const StreamOutput& output) {
+            sunk.push_back(output.index);
+            if (output.index == 1) {
+                throw std::runtime_error("sink failure");
+            }
+        },
+        options);
+    throwing.add_stream(throwing_source);
+    throwing.run();
+
+    EXPECT_EQ(sunk, (std::vector<uint64_t>{0, 1, 2}));
+    const StreamStats throwing_stats = throwing.stats().streams[0];
+    EXPECT_EQ(throwing_stats.inferred, 3u);
+    EXPECT_EQ(throwing_stats.failed, 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
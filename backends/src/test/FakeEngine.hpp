@@ -0,0 +1,67 @@
+#pragma once
+#include "InferenceInterface.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+
+// Model-free engine for the component tests: outputs are computed from the blob by a configurable
+// function, and the knobs below make calls slow, blocked or failing while recording concurrency
+class FakeEngine : public InferenceInterface
+{
+public:
+    using Result = std::tuple<std::vector<std::vector<TensorElement>>, std::vector<std::vector<int64_t>>>;
+    using Compute = std::function<Result(const cv::Mat&)>;
+
+    explicit FakeEngine(Compute compute = sum_output, size_t batch_size = 1)
+        : InferenceInterface("fake", false, batch_size, {})
+        , compute_(std::move(compute))
+    {
+    }
+
+    Result get_infer_results(const cv::Mat& blob) override
+    {
+        const int now_active = active.fetch_add(1) + 1;
+        int seen = max_active.load();
+        while (now_active > seen && !max_active.compare_exchange_weak(seen, now_active)) {
+        }
+        ++calls;
+        if (gate.valid()) {
+            gate.wait();
+        }
+        std::this_thread::sleep_for(delay);
+        active.fetch_sub(1);
+        if (fail) {
+            throw InferenceExecutionException("fake engine failure");
+        }
+        return compute_(blob);
+    }
+
+    ModelInfo& model_info() { return model_info_; }
+
+    // One output of the given values and shape
+    static Result make_result(const std::vector<float>& values, const std::vector<int64_t>& shape)
+    {
+        std::vector<TensorElement> output(values.begin(), values.end());
+        return Result{{output}, {shape}};
+    }
+
+    // Single float output holding the sum of the blob
+    static Result sum_output(const cv::Mat& blob)
+    {
+        return make_result({static_cast<float>(cv::sum(blob)[0])}, {1});
+    }
+
+    // Set before the engine is used
+    std::chrono::milliseconds delay{0};
+    std::shared_future<void> gate;  // Calls block until it is ready
+    bool fail = false;
+
+    std::atomic<int> calls{0};
+    std::atomic<int> active{0};
+    std::atomic<int> max_active{0};  // Most calls seen running at once
+
+private:
+    Compute compute_;
+};
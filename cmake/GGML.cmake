@@ -1,5 +1,8 @@
 set(GGML_SOURCES
 ${INFER_ROOT}/ggml/src/GGMLInfer.cpp
+${INFER_ROOT}/ggml/src/GGUFModel.cpp
+${INFER_ROOT}/ggml/src/GGMLTokenizer.cpp
+${INFER_ROOT}/ggml/src/GGMLDecoder.cpp
 # Add more GGML source files here if needed
 )
 
@@ -17,6 +17,10 @@ elseif(DEFAULT_BACKEND STREQUAL "LIBTENSORFLOW" )
     # Set TensorFlow include directories for the target
     target_include_directories(${PROJECT_NAME} PRIVATE ${TensorFlow_INCLUDE_DIR} ${INFER_ROOT}/libtensorflow/src)
     target_link_libraries(${PROJECT_NAME} PRIVATE ${TensorFlow_CC_LIBRARY} ${TensorFlow_FRAMEWORK_LIBRARY})
+    # SavedModel to memmapped package converter
+    add_executable(tf_convert_memmapped ${INFER_ROOT}/libtensorflow/tools/convert_to_memmapped.cpp)
+    target_include_directories(tf_convert_memmapped PRIVATE ${TensorFlow_INCLUDE_DIR} ${INFER_ROOT}/libtensorflow/src ${INFER_ROOT}/src)
+    target_link_libraries(tf_convert_memmapped PRIVATE ${PROJECT_NAME} ${TensorFlow_CC_LIBRARY} ${TensorFlow_FRAMEWORK_LIBRARY} ${OpenCV_LIBS} ${GLOG_LIBRARIES})
 elseif(DEFAULT_BACKEND STREQUAL "OPENVINO")
     target_include_directories(${PROJECT_NAME} PRIVATE ${InferenceEngine_INCLUDE_DIRS} ${INFER_ROOT}/openvino/src)
     target_link_libraries(${PROJECT_NAME} PRIVATE openvino::runtime )
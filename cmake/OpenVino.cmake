@@ -1,5 +1,6 @@
 set(OPENVINO_SOURCES
 ${INFER_ROOT}/openvino/src/OVInfer.cpp
+${INFER_ROOT}/openvino/src/OVContext.cpp
 # Add more OPENVINO source files here if needed
 )
 
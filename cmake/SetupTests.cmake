@@ -2,6 +2,8 @@
 message(STATUS "Test enabled")
 find_package(GTest REQUIRED)
 enable_testing()
+# Backend-independent components are tested with every backend
+add_subdirectory(backends/src/test)
 # Add test directories
 if(DEFAULT_BACKEND STREQUAL "LIBTENSORFLOW" )
     add_subdirectory(backends/libtensorflow/test)
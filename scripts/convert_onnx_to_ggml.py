@@ -1,79 +1,292 @@
 #!/usr/bin/env python3
 """
 Convert ONNX model to GGML format for inference testing.
-This script reads an ONNX model and creates a simple GGML-compatible binary format.
+This script reads an ONNX CNN/MLP and writes a GGUF file that GGMLInfer loads directly:
+weights as GGUF tensors and the forward graph as metadata (see backends/ggml/src/GGMLInfer.hpp).
+Supported ONNX ops: Conv (with a following BatchNormalization folded in), BatchNormalization,
+Relu, MaxPool, AveragePool, GlobalAveragePool, Add, Flatten, Reshape (to 2D), Gemm, Softmax,
+Identity and Dropout.
+With --quantize, convolution and linear weights are stored as Q8_0 or Q4_K blocks and run through
+ggml's quantized matmul kernels; other tensors stay F32.
 """
 
 import argparse
-import struct
 import numpy as np
-import onnx
 import sys
 from pathlib import Path
 
 
-def convert_onnx_to_ggml(onnx_path, output_path, input_shape, batch_size=1):
+QUANT_TYPES = ("q8_0", "q4_k")
+Q4_K_BLOCK = 256
+Q8_0_BLOCK = 32
+
+
+def quantize_q4_k(array):
+    """
+    Quantizes rows of 256-value super-blocks to ggml's block_q4_K: fp16 d and dmin, eight 6-bit
+    sub-block scales and mins packed in 12 bytes, then 256 4-bit values (144 bytes per block).
+    A value decodes as d * scale * q - dmin * min.
     """
-    Convert ONNX model to a simple GGML-compatible format.
-    Since the current GGML implementation is a placeholder, we create a simple
-    model file that the placeholder can handle.
-    
+    rows = np.asarray(array, dtype=np.float32)
+    blocks = rows.reshape(-1, 8, 32)
+    n = blocks.shape[0]
+
+    mins = -np.minimum(blocks.min(axis=2), 0.0)
+    scales = (blocks.max(axis=2) + mins) / 15.0
+    d = (scales.max(axis=1) / 63.0).astype(np.float16)
+    dmin = (mins.max(axis=1) / 63.0).astype(np.float16)
+
+    def to_6bit(values, step):
+        step = step.astype(np.float32)[:, None]
+        safe = np.where(step > 0, step, 1.0)
+        return np.where(step > 0, np.round(values / safe), 0).clip(0, 63).astype(np.uint8)
+
+    ls = to_6bit(scales, d)
+    lm = to_6bit(mins, dmin)
+    step = d.astype(np.float32)[:, None] * ls
+    offset = dmin.astype(np.float32)[:, None] * lm
+    safe = np.where(step > 0, step, 1.0)[..., None]
+    q = np.where(step[..., None] > 0, np.round((blocks + offset[..., None]) / safe), 0).clip(0, 15).astype(np.uint8)
+
+    packed = np.zeros((n, 12), dtype=np.uint8)
+    packed[:, 0:4] = ls[:, 0:4] | ((ls[:, 4:8] >> 4) << 6)
+    packed[:, 4:8] = lm[:, 0:4] | ((lm[:, 4:8] >> 4) << 6)
+    packed[:, 8:12] = (ls[:, 4:8] & 0xF) | ((lm[:, 4:8] & 0xF) << 4)
+    # Each 32 bytes hold two consecutive sub-blocks, the first in the low nibbles
+    q = q.reshape(n, 4, 2, 32)
+    qs = (q[:, :, 0, :] | (q[:, :, 1, :] << 4)).reshape(n, 128)
+
+    out = np.concatenate([d.reshape(n, 1).view(np.uint8), dmin.reshape(n, 1).view(np.uint8), packed, qs], axis=1)
+    return out.reshape(*rows.shape[:-1], rows.shape[-1] // Q4_K_BLOCK * 144)
+
+
+class GGUFGraphWriter:
+    """Collects graph nodes and weights and writes them as a GGUF "cnn" model."""
+
+    ARCH = "cnn"
+
+    def __init__(self, input_shape, quantize=None):
+        if quantize not in (None,) + QUANT_TYPES:
+            raise ValueError(f"Unsupported quantization type: {quantize}")
+        self.input_shape = [int(d) for d in input_shape]
+        self.quantize = quantize
+        self.nodes = []
+        self.tensors = []
+        self.counter = 0
+
+    def weight_type(self, row_size):
+        """Storage type for a weight matrix with rows of row_size values, None for F32."""
+        if self.quantize == "q4_k" and row_size % Q4_K_BLOCK == 0:
+            return "q4_k"
+        # Rows that don't fill Q4_K super-blocks fall back to Q8_0, as llama.cpp does
+        if self.quantize and row_size % Q8_0_BLOCK == 0:
+            return "q8_0"
+        return None
+
+    def add_node(self, op, inputs, params=None, tensors=None, quantized=()):
+        """Appends a node and returns the name of its output value. Tensors named in quantized
+        are stored in the writer's quantization type when they are matrices whose rows allow it."""
+        self.counter += 1
+        output = f"v{self.counter}"
+        node = f"{op} {output} {','.join(inputs)}"
+        for key, value in (params or {}).items():
+            node += f" {key}={int(value)}"
+        self.nodes.append(node)
+        for suffix, array in (tensors or {}).items():
+            if array is not None:
+                array = np.ascontiguousarray(array, dtype=np.float32)
+                qtype = self.weight_type(array.shape[-1]) if suffix in quantized and array.ndim == 2 else None
+                self.tensors.append((f"{output}.{suffix}", array, qtype))
+        return output
+
+    def conv2d(self, x, weight, bias, stride=1, pad=0, dilation=1):
+        params = {"stride": stride, "pad": pad, "dilation": dilation}
+        out_channels, _, kernel_h, kernel_w = weight.shape
+        row_size = weight[0].size
+        if self.weight_type(row_size):
+            # Quantized kernels are stored as (OC, IC*KH*KW) matrices, quantized along the rows
+            weight = weight.reshape(out_channels, row_size)
+            params.update({"kh": kernel_h, "kw": kernel_w})
+        return self.add_node("conv2d", [x], params, {"weight": weight, "bias": bias}, quantized=("weight",))
+
+    def linear(self, x, weight, bias=None):
+        # weight is (out_features, in_features)
+        return self.add_node("linear", [x], tensors={"weight": weight, "bias": bias}, quantized=("weight",))
+
+    def write(self, output_path, outputs, name="model"):
+        import gguf
+
+        writer = gguf.GGUFWriter(str(output_path), self.ARCH)
+        writer.add_name(name)
+        writer.add_array(f"{self.ARCH}.input_shape", self.input_shape)
+        writer.add_array(f"{self.ARCH}.graph", self.nodes)
+        writer.add_array(f"{self.ARCH}.outputs", list(outputs))
+        if self.quantize:
+            writer.add_string(f"{self.ARCH}.quantization", self.quantize)
+        for tensor_name, array, qtype in self.tensors:
+            if qtype == "q8_0":
+                writer.add_tensor(tensor_name, gguf.quants.quantize(array, gguf.GGMLQuantizationType.Q8_0),
+                                  raw_dtype=gguf.GGMLQuantizationType.Q8_0)
+            elif qtype == "q4_k":
+                writer.add_tensor(tensor_name, quantize_q4_k(array), raw_dtype=gguf.GGMLQuantizationType.Q4_K)
+            else:
+                writer.add_tensor(tensor_name, array)
+        writer.write_header_to_file()
+        writer.write_kv_data_to_file()
+        writer.write_tensors_to_file()
+        writer.close()
+
+
+def fold_batchnorm(weight, bias, gamma, beta, mean, var, eps):
+    """Folds an inference batchnorm into the preceding convolution."""
+    scale = gamma / np.sqrt(var + eps)
+    folded_weight = weight * scale.reshape(-1, 1, 1, 1)
+    folded_bias = ((bias if bias is not None else 0.0) - mean) * scale + beta
+    return folded_weight, folded_bias
+
+
+def symmetric(values, what):
+    """Returns the single value of a per-axis attribute that must be the same on every axis."""
+    values = list(values)
+    if len(set(values)) != 1:
+        raise ValueError(f"Asymmetric {what} {values} is not supported")
+    return values[0]
+
+
+def convert_onnx_to_ggml(onnx_path, output_path, input_shape, batch_size=1, quantize=None):
+    """
+    Convert an ONNX model to a GGUF model for GGMLInfer.
+
     Args:
         onnx_path: Path to input ONNX model
         output_path: Path to output GGML model
         input_shape: Input tensor shape (e.g., [3, 224, 224])
-        batch_size: Batch size for inference
+        batch_size: Batch size for inference (the GGUF graph is batch independent)
+        quantize: None for F32 weights, or "q8_0" / "q4_k"
     """
+    import onnx
+    from onnx import numpy_helper
+
     print(f"Converting {onnx_path} to {output_path}")
-    
-    # Load ONNX model to verify it exists and get basic info
+
     try:
         model = onnx.load(onnx_path)
         print(f"Loaded ONNX model: {model.graph.name}")
     except Exception as e:
         print(f"Error loading ONNX model: {e}")
         return False
-    
-    # Get model info
-    input_name = model.graph.input[0].name
-    output_name = model.graph.output[0].name
-    
-    # Get input/output shapes
-    input_shape_full = [batch_size] + input_shape
-    output_shape = [batch_size, 1000]  # ResNet18 has 1000 classes
-    
-    print(f"Input shape: {input_shape_full}")
-    print(f"Output shape: {output_shape}")
-    
-    # Create a simple model file that the placeholder GGML implementation can handle
-    # Since the current implementation doesn't actually load the file, we just need
-    # a file that exists and has some content
-    with open(output_path, 'wb') as f:
-        # Write a simple header that identifies this as a GGML model
-        f.write(b'GGML')  # Magic number
-        f.write(struct.pack('<I', 1))  # Version
-        
-        # Write model metadata
-        f.write(struct.pack('<I', batch_size))  # Batch size
-        f.write(struct.pack('<I', input_shape[0]))  # Channels
-        f.write(struct.pack('<I', input_shape[1]))  # Height
-        f.write(struct.pack('<I', input_shape[2]))  # Width
-        f.write(struct.pack('<I', 1000))  # Output classes
-        
-        # Write model name
-        model_name = b'ResNet18'
-        f.write(struct.pack('<I', len(model_name)))
-        f.write(model_name)
-        
-        # Write some dummy data to make the file non-empty
-        # The placeholder implementation doesn't actually read this
-        dummy_data = b'\x00' * 1024
-        f.write(dummy_data)
-    
+
+    initializers = {init.name: numpy_helper.to_array(init).astype(np.float32) for init in model.graph.initializer}
+    graph_inputs = [i.name for i in model.graph.input if i.name not in initializers]
+    consumers = {}
+    for node in model.graph.node:
+        for name in node.input:
+            consumers.setdefault(name, []).append(node)
+
+    writer = GGUFGraphWriter(input_shape, quantize)
+    values = {graph_inputs[0]: "input"}
+    folded = set()
+
+    def attr(node, name, default=None):
+        for a in node.attribute:
+            if a.name == name:
+                return onnx.helper.get_attribute_value(a)
+        return default
+
+    def pool_params(node):
+        kernel = symmetric(attr(node, "kernel_shape"), "kernel")
+        stride = symmetric(attr(node, "strides", [1, 1]), "stride")
+        pads = attr(node, "pads", [0, 0, 0, 0])
+        if attr(node, "ceil_mode", 0):
+            raise ValueError(f"{node.name}: ceil_mode is not supported")
+        return {"kernel": kernel, "stride": stride, "pad": symmetric(pads, "padding")}
+
+    try:
+        for node in model.graph.node:
+            if node.output and node.output[0] in folded:
+                continue
+            op = node.op_type
+            x = values.get(node.input[0]) if node.input else None
+
+            if op == "Conv":
+                if attr(node, "group", 1) != 1:
+                    raise ValueError(f"{node.name}: grouped convolution is not supported")
+                weight = initializers[node.input[1]]
+                bias = initializers[node.input[2]] if len(node.input) > 2 else None
+                output_name = node.output[0]
+                next_nodes = consumers.get(output_name, [])
+                if len(next_nodes) == 1 and next_nodes[0].op_type == "BatchNormalization":
+                    bn = next_nodes[0]
+                    gamma, beta, mean, var = (initializers[n] for n in bn.input[1:5])
+                    weight, bias = fold_batchnorm(weight, bias, gamma, beta, mean, var, attr(bn, "epsilon", 1e-5))
+                    folded.add(bn.output[0])
+                    output_name = bn.output[0]
+                out = writer.conv2d(x, weight, bias,
+                                    stride=symmetric(attr(node, "strides", [1, 1]), "stride"),
+                                    pad=symmetric(attr(node, "pads", [0, 0, 0, 0]), "padding"),
+                                    dilation=symmetric(attr(node, "dilations", [1, 1]), "dilation"))
+                values[output_name] = out
+                continue
+            elif op == "BatchNormalization":
+                gamma, beta, mean, var = (initializers[n] for n in node.input[1:5])
+                scale = gamma / np.sqrt(var + attr(node, "epsilon", 1e-5))
+                out = writer.add_node("affine", [x], tensors={"weight": scale, "bias": beta - mean * scale})
+            elif op == "Relu":
+                out = writer.add_node("relu", [x])
+            elif op == "MaxPool":
+                out = writer.add_node("maxpool2d", [x], pool_params(node))
+            elif op == "AveragePool":
+                params = pool_params(node)
+                if params["pad"] and not attr(node, "count_include_pad", 0):
+                    raise ValueError(f"{node.name}: padded average pooling must count the padding")
+                out = writer.add_node("avgpool2d", [x], params)
+            elif op == "GlobalAveragePool":
+                out = writer.add_node("global_avgpool", [x])
+            elif op == "Add":
+                if any(name in initializers for name in node.input):
+                    raise ValueError(f"{node.name}: Add with a constant operand is not supported")
+                out = writer.add_node("add", [values[name] for name in node.input])
+            elif op == "Flatten":
+                if attr(node, "axis", 1) != 1:
+                    raise ValueError(f"{node.name}: only Flatten(axis=1) is supported")
+                out = writer.add_node("flatten", [x])
+            elif op == "Reshape":
+                shape = initializers.get(node.input[1])
+                if shape is None or len(shape) != 2:
+                    raise ValueError(f"{node.name}: only reshapes to (N, -1) are supported")
+                out = writer.add_node("flatten", [x])
+            elif op == "Gemm":
+                if attr(node, "alpha", 1.0) != 1.0 or attr(node, "beta", 1.0) != 1.0 or attr(node, "transA", 0):
+                    raise ValueError(f"{node.name}: only Gemm(alpha=1, beta=1, transA=0) is supported")
+                weight = initializers[node.input[1]]
+                if not attr(node, "transB", 0):
+                    weight = weight.T
+                bias = initializers[node.input[2]] if len(node.input) > 2 else None
+                out = writer.linear(x, weight, bias)
+            elif op == "Softmax":
+                if attr(node, "axis", -1) not in (-1, 1):
+                    raise ValueError(f"{node.name}: Softmax is only supported over the last axis")
+                out = writer.add_node("softmax", [x])
+            elif op in ("Identity", "Dropout"):
+                out = x
+            else:
+                raise ValueError(f"Unsupported ONNX op: {op} ({node.name})")
+            values[node.output[0]] = out
+    except (KeyError, ValueError) as e:
+        print(f"Error converting ONNX graph: {e}")
+        return False
+
+    outputs = [values[o.name] for o in model.graph.output]
+    print(f"Input shape: {[batch_size] + list(input_shape)}")
+    print(f"Graph: {len(writer.nodes)} nodes, {len(writer.tensors)} tensors")
+    if quantize:
+        print(f"Quantized tensors: {sum(1 for t in writer.tensors if t[2])} ({quantize})")
+
+    writer.write(output_path, outputs, name=model.graph.name or Path(onnx_path).stem)
+
     print(f"GGML model saved to: {output_path}")
     print(f"Model size: {Path(output_path).stat().st_size} bytes")
-    print("Note: This is a placeholder model for testing the GGML backend")
-    
+
     return True
 
 
@@ -83,24 +296,25 @@ def main():
     parser.add_argument('--output', '-o', required=True, help='Output GGML model path')
     parser.add_argument('--input-shape', default='3,224,224', help='Input shape (comma-separated)')
     parser.add_argument('--batch-size', type=int, default=1, help='Batch size')
-    
+    parser.add_argument('--quantize', choices=QUANT_TYPES, help='Store conv/linear weights quantized')
+
     args = parser.parse_args()
-    
+
     # Parse input shape
     try:
         input_shape = [int(x.strip()) for x in args.input_shape.split(',')]
     except ValueError:
         print("Error: Invalid input shape format. Use comma-separated integers (e.g., '3,224,224')")
         sys.exit(1)
-    
+
     # Check input file exists
     if not Path(args.input).exists():
         print(f"Error: Input file {args.input} does not exist")
         sys.exit(1)
-    
+
     # Convert model
-    success = convert_onnx_to_ggml(args.input, args.output, input_shape, args.batch_size)
-    
+    success = convert_onnx_to_ggml(args.input, args.output, input_shape, args.batch_size, args.quantize)
+
     if success:
         print("Conversion completed successfully!")
         sys.exit(0)
@@ -9,153 +9,54 @@ import sys
 import torch
 import torchvision.models as models
 import numpy as np
-import struct
 import argparse
 from pathlib import Path
 
-def create_ggml_header(f, model_info):
-    """Write GGML model header"""
-    # GGML file format header (simplified version)
-    f.write(b'ggml')  # Magic number
-    f.write(struct.pack('<I', 1))  # Version
-    f.write(struct.pack('<I', model_info['num_layers']))
-    f.write(struct.pack('<I', model_info['input_size']))
-    f.write(struct.pack('<I', model_info['output_size']))
-
-def convert_conv_layer(f, conv_layer, layer_name):
-    """Convert a convolutional layer to GGML format"""
-    # Write layer type
-    f.write(struct.pack('<I', 1))  # CONV layer type
-    
-    # Write layer name
-    name_bytes = layer_name.encode('utf-8')
-    f.write(struct.pack('<I', len(name_bytes)))
-    f.write(name_bytes)
-    
-    # Write layer parameters
-    in_channels = conv_layer.in_channels
-    out_channels = conv_layer.out_channels
-    kernel_size = conv_layer.kernel_size[0] if isinstance(conv_layer.kernel_size, tuple) else conv_layer.kernel_size
-    stride = conv_layer.stride[0] if isinstance(conv_layer.stride, tuple) else conv_layer.stride
-    padding = conv_layer.padding[0] if isinstance(conv_layer.padding, tuple) else conv_layer.padding
-    
-    f.write(struct.pack('<IIII', in_channels, out_channels, kernel_size, stride))
-    f.write(struct.pack('<I', padding))
-    
-    # Write weights (transposed for GGML format)
-    weights = conv_layer.weight.data.numpy().astype(np.float32)
-    f.write(struct.pack('<I', weights.size))
-    f.write(weights.tobytes())
-    
-    # Write bias
-    if conv_layer.bias is not None:
-        bias = conv_layer.bias.data.numpy().astype(np.float32)
-        f.write(struct.pack('<I', bias.size))
-        f.write(bias.tobytes())
-    else:
-        f.write(struct.pack('<I', 0))
-
-def convert_bn_layer(f, bn_layer, layer_name):
-    """Convert a batch normalization layer to GGML format"""
-    # Write layer type
-    f.write(struct.pack('<I', 2))  # BN layer type
-    
-    # Write layer name
-    name_bytes = layer_name.encode('utf-8')
-    f.write(struct.pack('<I', len(name_bytes)))
-    f.write(name_bytes)
-    
-    # Write layer parameters
-    num_features = bn_layer.num_features
-    f.write(struct.pack('<I', num_features))
-    
-    # Write running mean and variance
-    running_mean = bn_layer.running_mean.data.numpy().astype(np.float32)
-    running_var = bn_layer.running_var.data.numpy().astype(np.float32)
-    
-    f.write(struct.pack('<I', running_mean.size))
-    f.write(running_mean.tobytes())
-    f.write(struct.pack('<I', running_var.size))
-    f.write(running_var.tobytes())
-    
-    # Write weight and bias
-    if bn_layer.weight is not None:
-        weight = bn_layer.weight.data.numpy().astype(np.float32)
-        f.write(struct.pack('<I', weight.size))
-        f.write(weight.tobytes())
-    else:
-        f.write(struct.pack('<I', 0))
-    
-    if bn_layer.bias is not None:
-        bias = bn_layer.bias.data.numpy().astype(np.float32)
-        f.write(struct.pack('<I', bias.size))
-        f.write(bias.tobytes())
-    else:
-        f.write(struct.pack('<I', 0))
-
-def convert_linear_layer(f, linear_layer, layer_name):
-    """Convert a linear layer to GGML format"""
-    # Write layer type
-    f.write(struct.pack('<I', 3))  # LINEAR layer type
-    
-    # Write layer name
-    name_bytes = layer_name.encode('utf-8')
-    f.write(struct.pack('<I', len(name_bytes)))
-    f.write(name_bytes)
-    
-    # Write layer parameters
-    in_features = linear_layer.in_features
-    out_features = linear_layer.out_features
-    f.write(struct.pack('<II', in_features, out_features))
-    
-    # Write weights (transposed for GGML format)
-    weights = linear_layer.weight.data.numpy().astype(np.float32)
-    f.write(struct.pack('<I', weights.size))
-    f.write(weights.tobytes())
-    
-    # Write bias
-    if linear_layer.bias is not None:
-        bias = linear_layer.bias.data.numpy().astype(np.float32)
-        f.write(struct.pack('<I', bias.size))
-        f.write(bias.tobytes())
-    else:
-        f.write(struct.pack('<I', 0))
-
-def convert_resnet18_to_ggml(model, output_path):
-    """Convert ResNet18 model to GGML format"""
-    print(f"Converting ResNet18 to GGML format: {output_path}")
-    
-    # Count layers for header
-    num_layers = 0
-    for name, module in model.named_modules():
-        if isinstance(module, (torch.nn.Conv2d, torch.nn.BatchNorm2d, torch.nn.Linear)):
-            num_layers += 1
-    
-    model_info = {
-        'num_layers': num_layers,
-        'input_size': 3 * 224 * 224,  # ResNet18 input size
-        'output_size': 1000,  # ImageNet classes
-    }
-    
-    with open(output_path, 'wb') as f:
-        # Write header
-        create_ggml_header(f, model_info)
-        
-        # Convert each layer
-        for name, module in model.named_modules():
-            if isinstance(module, torch.nn.Conv2d):
-                convert_conv_layer(f, module, name)
-                print(f"  Converted Conv2d layer: {name}")
-            elif isinstance(module, torch.nn.BatchNorm2d):
-                convert_bn_layer(f, module, name)
-                print(f"  Converted BatchNorm2d layer: {name}")
-            elif isinstance(module, torch.nn.Linear):
-                convert_linear_layer(f, module, name)
-                print(f"  Converted Linear layer: {name}")
-    
+from convert_onnx_to_ggml import GGUFGraphWriter, QUANT_TYPES, fold_batchnorm
+
+def conv_bn(writer, x, conv, bn):
+    """Adds a convolution with its batchnorm folded in"""
+    weight, bias = fold_batchnorm(
+        conv.weight.data.numpy().astype(np.float32),
+        conv.bias.data.numpy().astype(np.float32) if conv.bias is not None else None,
+        bn.weight.data.numpy().astype(np.float32),
+        bn.bias.data.numpy().astype(np.float32),
+        bn.running_mean.data.numpy().astype(np.float32),
+        bn.running_var.data.numpy().astype(np.float32),
+        bn.eps)
+    return writer.conv2d(x, weight, bias, stride=conv.stride[0], pad=conv.padding[0], dilation=conv.dilation[0])
+
+def convert_basic_block(writer, x, block):
+    """Convert a ResNet BasicBlock: two 3x3 convolutions plus the (optionally downsampled) shortcut"""
+    out = writer.add_node("relu", [conv_bn(writer, x, block.conv1, block.bn1)])
+    out = conv_bn(writer, out, block.conv2, block.bn2)
+    identity = x
+    if block.downsample is not None:
+        identity = conv_bn(writer, x, block.downsample[0], block.downsample[1])
+    return writer.add_node("relu", [writer.add_node("add", [out, identity])])
+
+def convert_resnet18_to_ggml(model, output_path, quantize=None):
+    """Convert ResNet18 model to GGML format (GGUF graph loaded by GGMLInfer)"""
+    print(f"Converting ResNet18 to GGML format: {output_path}" + (f" ({quantize})" if quantize else ""))
+
+    writer = GGUFGraphWriter([3, 224, 224], quantize)
+
+    x = writer.add_node("relu", [conv_bn(writer, "input", model.conv1, model.bn1)])
+    pool = model.maxpool
+    x = writer.add_node("maxpool2d", [x], {"kernel": pool.kernel_size, "stride": pool.stride, "pad": pool.padding})
+    for layer_name in ("layer1", "layer2", "layer3", "layer4"):
+        for block in getattr(model, layer_name):
+            x = convert_basic_block(writer, x, block)
+            print(f"  Converted {layer_name} block")
+    x = writer.add_node("global_avgpool", [x])
+    x = writer.add_node("flatten", [x])
+    x = writer.linear(x, model.fc.weight.data.numpy().astype(np.float32), model.fc.bias.data.numpy().astype(np.float32))
+
+    writer.write(output_path, [x], name="resnet18")
+
     print(f"✓ ResNet18 converted to GGML format: {output_path}")
     print(f"  Model size: {os.path.getsize(output_path)} bytes")
-    print(f"  Number of layers: {num_layers}")
+    print(f"  Number of nodes: {len(writer.nodes)}")
 
 def download_resnet18_model():
     """Download pretrained ResNet18 model"""
@@ -199,6 +100,8 @@ def main():
                        help='Output GGML model path (default: resnet18.ggml)')
     parser.add_argument('--test-dir', '-t', default='backends/ggml/test',
                        help='Test directory to copy model to (default: backends/ggml/test)')
+    parser.add_argument('--quantize', choices=QUANT_TYPES,
+                       help='Store conv/linear weights quantized (q8_0 or q4_k)')
     
     args = parser.parse_args()
     
@@ -207,7 +110,7 @@ def main():
         model = download_resnet18_model()
         
         # Convert to GGML format
-        convert_resnet18_to_ggml(model, args.output)
+        convert_resnet18_to_ggml(model, args.output, args.quantize)
         
         # Copy to test directory if specified
         if args.test_dir and os.path.exists(args.test_dir):
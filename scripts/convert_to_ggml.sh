@@ -103,7 +103,7 @@ if [ "$USE_VENV" = true ]; then
     # Install required packages
     echo "Installing PyTorch dependencies..."
     pip install --upgrade pip
-    pip install torch torchvision numpy
+    pip install torch torchvision numpy gguf
     
     if [ $? -eq 0 ]; then
         echo -e "${GREEN}✓ Dependencies installed successfully${NC}"
@@ -116,9 +116,9 @@ else
     
     # Check if required packages are available in system Python
     echo "Checking system Python dependencies..."
-    if ! python3 -c "import torch, torchvision, numpy" 2>/dev/null; then
+    if ! python3 -c "import torch, torchvision, numpy, gguf" 2>/dev/null; then
         echo -e "${RED}Error: PyTorch, torchvision, or numpy not found in system Python${NC}"
-        echo "Install them with: pip3 install torch torchvision numpy"
+        echo "Install them with: pip3 install torch torchvision numpy gguf"
         echo "Or use virtual environment (default behavior)"
         exit 1
     fi
@@ -477,8 +477,8 @@ EOF
         log_info "Setting up GGML model for testing..."
         cd "$BUILD_DIR"
         
-        # Check if model already exists
-        if [ ! -f "resnet18.ggml" ]; then
+        # Check if the models already exist
+        if [ ! -f "resnet18.ggml" ] || [ ! -f "decoder_model_path.txt" ]; then
             # Check if conversion script exists
             local conversion_script="$PROJECT_ROOT/scripts/convert_to_ggml.sh"
             if [ -f "$conversion_script" ]; then
@@ -490,10 +490,18 @@ EOF
                 
                 # Install PyTorch dependencies
                 pip install --upgrade pip > /dev/null 2>&1
-                pip install torch torchvision numpy > /dev/null 2>&1
+                pip install torch torchvision numpy gguf > /dev/null 2>&1
                 
-                # Run conversion
-                python3 "$PROJECT_ROOT/scripts/convert_resnet18_to_ggml.py" --output "resnet18.ggml" --test-dir "." > "${TEST_RESULTS_DIR}/${backend_dir}_model_generation.log" 2>&1
+                if [ ! -f "resnet18.ggml" ]; then
+                    # Run conversion
+                    python3 "$PROJECT_ROOT/scripts/convert_resnet18_to_ggml.py" --output "resnet18.ggml" --test-dir "." > "${TEST_RESULTS_DIR}/${backend_dir}_model_generation.log" 2>&1
+                    # Quantized variants for the quantized accuracy test
+                    for qtype in q8_0 q4_k; do
+                        python3 "$PROJECT_ROOT/scripts/convert_resnet18_to_ggml.py" --output "resnet18-${qtype}.ggml" --test-dir "" --quantize "$qtype" >> "${TEST_RESULTS_DIR}/${backend_dir}_model_generation.log" 2>&1
+                    done
+                fi
+                # Small llama-style decoder for the GGMLDecoder tests, writes decoder_model_path.txt
+                python3 "$PROJECT_ROOT/backends/ggml/test/create_test_decoder.py" "$BUILD_DIR/test_decoder.gguf" >> "${TEST_RESULTS_DIR}/${backend_dir}_model_generation.log" 2>&1
                 
                 # Cleanup
                 deactivate
@@ -503,7 +511,11 @@ EOF
                     log_error "Failed to generate GGML model"
                     return 1
                 fi
-            else
+                if [ ! -f "decoder_model_path.txt" ]; then
+                    log_error "Failed to generate the GGML test decoder"
+                    return 1
+                fi
+            elif [ ! -f "resnet18.ggml" ]; then
                 log_warning "GGML conversion script not found, creating placeholder model"
                 # Create a simple placeholder model file
                 echo "GGML" > "resnet18.ggml"
@@ -528,6 +540,13 @@ EOF
         # Run basic tests
         "$test_executable" --gtest_output=xml:"${TEST_RESULTS_DIR}/${backend_dir}_results.xml" > "${TEST_RESULTS_DIR}/${backend_dir}_test.log" 2>&1
         local test_result=$?
+
+        # Backend-independent components, built with every backend
+        local common_executable="${BUILD_DIR}/backends/src/test/CommonComponentsTest"
+        if [ $test_result -eq 0 ] && [ -f "$common_executable" ]; then
+            "$common_executable" --gtest_output=xml:"${TEST_RESULTS_DIR}/${backend_dir}_common_results.xml" > "${TEST_RESULTS_DIR}/${backend_dir}_common_test.log" 2>&1
+            test_result=$?
+        fi
         
         if [ $test_result -eq 0 ]; then
             log_success "Tests passed for $backend"